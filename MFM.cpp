@@ -5,6 +5,9 @@
 */
 //------------------------------------------------------------------------------
 #include "MFM.h"
+#if defined ( MFM_USE_EEPROM )
+    #include <EEPROM.h>
+#endif
 //------------------------------------------------------------------------------
 #if defined ( USE_HARDWARESERIAL )
 #if defined ( ESP8266 )
@@ -62,7 +65,8 @@ void MFM::begin(void) {
 #endif
 #else
 #if defined ( ESP8266 ) || defined ( ESP32 )
-    MFMSer.begin(_baud, (EspSoftwareSerial::Config)_config, _rx_pin, _tx_pin);
+    MFMSer.begin(_baud, (EspSoftwareSerial::Config)_config, _rx_pin, _tx_pin, false,
+                 MFM_SWSERIAL_BUFFER, MFM_SWSERIAL_ISR_BUFFER);
 #else
     MFMSer.begin(_baud);
 #endif
@@ -79,97 +83,298 @@ void MFM::begin(void) {
     dereSet(LOW);                                                                 //set init state to receive from MFM -> DE Disable, /RE Enable (for control MAX485)
 }
 
+#if !defined ( MFM_NO_FLOAT )
 float MFM::readVal(uint16_t reg, uint8_t node) {
-    uint16_t temp;
-    unsigned long resptime;
-    uint8_t MFMarr[FRAMESIZE] = {node, MFM_B_02, 0, 0, MFM_B_05, MFM_B_06, 0, 0, 0};
+    uint32_t raw;
     float res = NAN;
-    uint16_t readErr = MFM_ERR_NO_ERROR;
 
-    MFMarr[2] = highByte(reg);
-    MFMarr[3] = lowByte(reg);
+    if (readRaw(reg, node, &raw) == MFM_ERR_NO_ERROR)
+        memcpy(&res, &raw, sizeof(res));                                          //raw is ieee754 single, byte order already corrected
 
-    temp = calculateCRC(MFMarr,
-                        FRAMESIZE - 3);                                   //calculate out crc only from first 6 bytes
+    return (res);
+}
 
-    MFMarr[6] = lowByte(temp);
-    MFMarr[7] = highByte(temp);
+uint16_t MFM::readValBlock(uint16_t reg, uint8_t count, float *vals, uint8_t node) {
+    uint32_t raw[MFM_MAX_BLOCK];
+    uint16_t readErr = readRaw(reg, node, raw, count);
 
-#if !defined ( USE_HARDWARESERIAL )
-    MFMSer.listen();                                                              //enable softserial rx interrupt
+    for (uint8_t i = 0; i < count && i < MFM_MAX_BLOCK; i++) {
+        if (readErr == MFM_ERR_NO_ERROR)
+            memcpy(&vals[i], &raw[i], sizeof(float));
+        else
+            vals[i] = NAN;
+    }
+
+    return (readErr);
+}
 #endif
 
-    flush();                                                                      //read serial if any old data is available
+int32_t MFM::readValInt(uint16_t reg, uint8_t node, uint8_t decimals) {
+    uint32_t raw;
 
-    dereSet(HIGH);                                                                //transmit to MFM  -> DE Enable, /RE Disable (for control MAX485)
+    if (readRaw(reg, node, &raw) != MFM_ERR_NO_ERROR)
+        return (MFM_INT_NAN);
 
-    delay(2);                                                                     //fix for issue (nan reading) by sjfaustino: https://github.com/reaper7/MFM_Energy_Meter/issues/7#issuecomment-272111524
+    return (floatToInt(raw, decimals));
+}
 
-    MFMSer.write(MFMarr, FRAMESIZE - 1);                                          //send 8 bytes
+uint16_t MFM::readValIntBlock(uint16_t reg, uint8_t count, int32_t *vals, uint8_t node, uint8_t decimals) {
+    uint32_t raw[MFM_MAX_BLOCK];
+    uint16_t readErr = readRaw(reg, node, raw, count);
 
-    MFMSer.flush();                                                               //clear out tx buffer
+    for (uint8_t i = 0; i < count && i < MFM_MAX_BLOCK; i++)
+        vals[i] = (readErr == MFM_ERR_NO_ERROR) ? floatToInt(raw[i], decimals) : MFM_INT_NAN;
 
-    dereSet(LOW);                                                                 //receive from MFM -> DE Disable, /RE Enable (for control MAX485)
+    return (readErr);
+}
 
-    resptime = millis();
+uint16_t MFM::readRaw(uint16_t reg, uint8_t node, uint32_t *raw, uint8_t count) {
+    uint8_t MFMarr[MFM_REPLY_SIZE(MFM_MAX_BLOCK)];
+    uint16_t readErr = MFM_ERR_NO_ERROR;
 
-    while (MFMSer.available() < FRAMESIZE) {
-        if (millis() - resptime > msturnaround) {
-            readErr = MFM_ERR_TIMEOUT;                                                //err debug (4)
-            break;
+    if (count == 0 || count > MFM_MAX_BLOCK)
+        return (MFM_ERR_WRONG_BYTES);
+
+    rxEnable();                                                                   //enable softserial rx interrupt (if not in session)
+
+    readErr = transaction(MFMarr, reg, node, msturnaround, mstimeout, count);
+
+    if (readErr == MFM_ERR_NO_ERROR)
+        decodeReply(MFMarr, raw, count);
+
+    if (readErr !=
+        MFM_ERR_NO_ERROR) {                                            //if error then copy temp error value to global val and increment global error counter
+        readingerrcode = readErr;
+        readingerrcount++;
+    } else {
+        ++readingsuccesscount;
+    }
+
+    rxDisable();                                                                  //disable softserial rx interrupt (if not in session)
+
+    return (readErr);
+}
+
+int32_t MFM::floatToInt(uint32_t raw, uint8_t decimals) {
+    int16_t exp = (raw >> 23) & 0xFF;
+    uint32_t mant = raw & 0x007FFFFF;
+
+    if (exp == 0xFF)                                                              //nan or inf
+        return (MFM_INT_NAN);
+    if (exp == 0)                                                                 //zero or denormal, far below any useful resolution
+        return (0);
+
+    mant |= 0x00800000;                                                           //value = mant * 2^(exp - 150)
+    exp -= 150;
+
+    while (decimals--) {                                                          //scale by 10^decimals, keep mant below 2^28 so *10 fits in 32 bits
+        while (mant >= 0x10000000UL) {
+            mant >>= 1;
+            exp++;
         }
-        yield();
+        mant *= 10;
     }
 
-    if (readErr == MFM_ERR_NO_ERROR) {                                            //if no timeout...
+    if (exp >= 0) {
+        if (exp > 7 || mant > (0x7FFFFFFFUL >> exp))                              //does not fit in int32
+            return (MFM_INT_NAN);
+        mant <<= exp;
+    } else if (exp < -32) {                                                       //mant < 2^32, so result rounds to 0
+        mant = 0;
+    } else {
+        while (exp < -31) {
+            mant >>= 1;
+            exp++;
+        }
+        mant = (mant + (1UL << (-exp - 1))) >> -exp;                               //round to nearest
+        if (mant > 0x7FFFFFFFUL)
+            return (MFM_INT_NAN);
+    }
 
-        if (MFMSer.available() >= FRAMESIZE) {
+    return ((raw & 0x80000000UL) ? -(int32_t)mant : (int32_t)mant);
+}
 
-            for (int n = 0; n < FRAMESIZE; n++) {
-                MFMarr[n] = MFMSer.read();
-            }
+void MFM::beginSession() {
+#if !defined ( USE_HARDWARESERIAL )
+    MFMSer.listen();                                                              //enable softserial rx interrupt for whole session
+#endif
+    session = true;
+}
 
-            if (MFMarr[0] == node && MFMarr[1] == MFM_B_02 && MFMarr[2] == MFM_REPLY_BYTE_COUNT) {
+void MFM::endSession() {
+    session = false;
+#if !defined ( USE_HARDWARESERIAL )
+    MFMSer.stopListening();                                                       //disable softserial rx interrupt
+#endif
+}
 
-                if ((calculateCRC(MFMarr, FRAMESIZE - 2)) == ((MFMarr[8] << 8) |
-                                                              MFMarr[7])) {  //calculate crc from first 7 bytes and compare with received crc (bytes 7 & 8)
-                    ((uint8_t * ) & res)[3] = MFMarr[3]; //TODO: CHECK BYTE ORDER OF MFM384
-                    ((uint8_t * ) & res)[2] = MFMarr[4];
-                    ((uint8_t * ) & res)[1] = MFMarr[5];
-                    ((uint8_t * ) & res)[0] = MFMarr[6];
-                } else {
-                    readErr = MFM_ERR_CRC_ERROR;                                          //err debug (1)
-                }
+bool MFM::inSession() {
+    return (session);
+}
 
-            } else {
-                readErr = MFM_ERR_WRONG_BYTES;                                          //err debug (2)
-            }
+uint8_t MFM::discover(MFMNode *nodes, uint8_t maxnodes, uint8_t firstnode, uint8_t lastnode) {
+    uint8_t MFMarr[FRAMESIZE];
+    uint8_t found = 0;
+    uint16_t probetime = msturnaround;                                            //full turnaround until first responder measured bus latency
+
+    for (uint16_t node = firstnode; node <= lastnode && found < maxnodes; node++) {
+        uint16_t t = probetime;
+        uint16_t readErr;
+
+        rxEnable();                                                               //enable softserial rx interrupt (if not in session)
+
+        while (true) {
+            readErr = transaction(MFMarr, MFM_NEUTRAL_CURRENT, node, t, DISCOVERY_RESPONSE_TIMEOUT);  //register supported by all models
+            if (readErr == MFM_ERR_NO_ERROR || readErr == MFM_ERR_EXCEPTION || lastrxbytes == 0 || t >= msturnaround)
+                break;
+            t = (t * 2 < msturnaround) ? t * 2 : msturnaround;                          //bytes seen before deadline or while draining -> slow node or low baud, extend and retry
+        }
 
-        } else {
-            readErr = MFM_ERR_NOT_ENOUGHT_BYTES;                                      //err debug (3)
+        if (readErr == MFM_ERR_NO_ERROR) {
+            uint16_t minprobe = lastresptime * 2 + MFM_MIN_DELAY;                     //nodes on one bus respond similarly, keep next probes above twice this latency
+            if (minprobe < DISCOVERY_TURNAROUND_DELAY)
+                minprobe = DISCOVERY_TURNAROUND_DELAY;
+            if (found == 0 || minprobe > probetime)
+                probetime = (minprobe < msturnaround) ? minprobe : msturnaround;
+            nodes[found].node = node;
+            nodes[found].latency = lastresptime;
+            nodes[found].model = fingerprint(node, lastresptime);
+            found++;
         }
+        yield();
+    }
+
+    rxDisable();                                                                  //disable softserial rx interrupt (if not in session)
+
+    return (found);
+}
 
+uint8_t MFM::fingerprint(uint8_t node, uint16_t latency) {
+    static const struct {
+        uint16_t reg;
+        uint8_t models;
+    } probes[] = {                                                                //registers splitting support matrix from MFM.h
+        {MFM_VOLTAGE_V1N,         MFM_MODEL_ANY & ~MFM_MODEL_72D},
+        {MFM_VOLTAGE_V2N,         MFM_MODEL_630 | MFM_MODEL_72V2},
+        {MFM_KVAR1,               MFM_MODEL_630 | MFM_MODEL_230 | MFM_MODEL_220 | MFM_MODEL_120CT},
+        {MFM_THD_VOLTAGE_V23,     MFM_MODEL_630 | MFM_MODEL_230},
+        {MFM_THD_CURRENT_I1,      MFM_MODEL_230},
+        {MFM_KW_MIN_ACTIVE_POWER, MFM_MODEL_630}
+    };
+    uint8_t MFMarr[FRAMESIZE];
+    uint8_t models = MFM_MODEL_ANY;
+    uint16_t t = msturnaround;
+
+    if (latency && (latency * 2 + MFM_MIN_DELAY) < msturnaround)                  //known responder, no need to wait full turnaround for unsupported registers
+        t = latency * 2 + MFM_MIN_DELAY;
+
+    rxEnable();                                                                   //enable softserial rx interrupt (if not in session)
+
+    for (uint8_t i = 0; i < sizeof(probes) / sizeof(probes[0]); i++) {
+        uint8_t m = probes[i].models & models;
+        if (m == 0 || m == models)                                                  //register does not split remaining candidates
+            continue;
+        uint16_t pt = t;
+        uint8_t silent = 0;
+        for (uint8_t tries = 0; tries < FINGERPRINT_TRIES; tries++) {
+            uint16_t readErr = transaction(MFMarr, probes[i].reg, node, pt, DISCOVERY_RESPONSE_TIMEOUT);
+            if (readErr == MFM_ERR_NO_ERROR) {                                        //register supported
+                models = m;
+                break;
+            }
+            if (readErr == MFM_ERR_EXCEPTION) {                                       //clean exception reply, register not supported
+                models &= ~probes[i].models;
+                break;
+            }
+            if (readErr == MFM_ERR_TIMEOUT && lastrxbytes == 0) {
+                if (++silent == FINGERPRINT_TRIES)                                      //some models stay silent for unsupported registers
+                    models &= ~probes[i].models;
+                pt = msturnaround;                                                      //slow reply would be taken for reply to next probe, wait full turnaround
+            } else {
+                pt = (pt * 2 < msturnaround) ? pt * 2 : msturnaround;                   //crc error, noise or late reply, retry with more time
+            }
+            yield();
+        }                                                                           //garbled on all attempts: keep candidates, better ambiguous than wrong
+        yield();
     }
 
-    flush(mstimeout);                                                             //read serial if any old data is available and wait for RESPONSE_TIMEOUT (in ms)
+    rxDisable();                                                                  //disable softserial rx interrupt (if not in session)
 
-    if (MFMSer.available())                                                       //if serial rx buffer (after RESPONSE_TIMEOUT) still contains data then something spam rs485, check node(s) or increase RESPONSE_TIMEOUT
-        readErr = MFM_ERR_TIMEOUT;                                                  //err debug (4) but returned value may be correct
+    return (models);
+}
 
-    if (readErr !=
-        MFM_ERR_NO_ERROR) {                                            //if error then copy temp error value to global val and increment global error counter
-        readingerrcode = readErr;
-        readingerrcount++;
-    } else {
-        ++readingsuccesscount;
+#if defined ( MFM_USE_EEPROM )
+bool MFM::saveInventory(const MFMNode *nodes, uint8_t count) {
+    uint8_t buf[MFM_INVENTORY_SIZE];
+    uint8_t len;
+    uint16_t crc;
+
+    if (count > MFM_INVENTORY_MAX_NODES)
+        count = MFM_INVENTORY_MAX_NODES;
+
+    buf[0] = MFM_INVENTORY_MAGIC;
+    buf[1] = count;
+    buf[2] = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        buf[3 + i * 4] = nodes[i].node;
+        buf[4 + i * 4] = nodes[i].model;
+        buf[5 + i * 4] = lowByte(nodes[i].latency);
+        buf[6 + i * 4] = highByte(nodes[i].latency);
     }
+    len = 3 + count * 4;
+    crc = calculateCRC(buf, len);
+    buf[len] = lowByte(crc);
+    buf[len + 1] = highByte(crc);
 
-#if !defined ( USE_HARDWARESERIAL )
-    MFMSer.stopListening();                                                       //disable softserial rx interrupt
+#if defined ( ESP8266 ) || defined ( ESP32 )
+    if (EEPROM.length() == 0)                                                     //start emulated eeprom only if sketch did not, never end() it
+        EEPROM.begin(MFM_INVENTORY_ADDR + MFM_INVENTORY_SIZE);
+    if (EEPROM.length() < MFM_INVENTORY_ADDR + MFM_INVENTORY_SIZE)                //sketch started eeprom too small for inventory
+        return (false);
+#endif
+    for (uint8_t i = 0; i < len + 2; i++) {
+        if (EEPROM.read(MFM_INVENTORY_ADDR + i) != buf[i])                          //write only changed bytes to save flash/eeprom wear
+            EEPROM.write(MFM_INVENTORY_ADDR + i, buf[i]);
+    }
+#if defined ( ESP8266 ) || defined ( ESP32 )
+    return (EEPROM.commit());
+#else
+    return (true);
 #endif
+}
 
-    return (res);
+uint8_t MFM::loadInventory(MFMNode *nodes, uint8_t maxnodes) {
+    uint8_t buf[MFM_INVENTORY_SIZE];
+    uint8_t count = 0;
+    uint8_t len;
+
+#if defined ( ESP8266 ) || defined ( ESP32 )
+    if (EEPROM.length() == 0)                                                     //start emulated eeprom only if sketch did not, never end() it
+        EEPROM.begin(MFM_INVENTORY_ADDR + MFM_INVENTORY_SIZE);
+    if (EEPROM.length() < MFM_INVENTORY_ADDR + MFM_INVENTORY_SIZE)                //sketch started eeprom too small for inventory
+        return (0);
+#endif
+    buf[0] = EEPROM.read(MFM_INVENTORY_ADDR);
+    buf[1] = EEPROM.read(MFM_INVENTORY_ADDR + 1);
+    if (buf[0] == MFM_INVENTORY_MAGIC && buf[1] <= MFM_INVENTORY_MAX_NODES) {
+        len = 3 + buf[1] * 4;
+        for (uint8_t i = 2; i < len + 2; i++)
+            buf[i] = EEPROM.read(MFM_INVENTORY_ADDR + i);
+        if (calculateCRC(buf, len) == ((buf[len + 1] << 8) | buf[len]))           //ignore erased or corrupted inventory
+            count = buf[1];
+    }
+
+    if (count > maxnodes)
+        count = maxnodes;
+    for (uint8_t i = 0; i < count; i++) {
+        nodes[i].node = buf[3 + i * 4];
+        nodes[i].model = buf[4 + i * 4];
+        nodes[i].latency = (buf[6 + i * 4] << 8) | buf[5 + i * 4];
+    }
+
+    return (count);
 }
+#endif
 
 uint16_t MFM::getErrCode(bool _clear) {
     uint16_t _tmp = readingerrcode;
@@ -245,13 +450,143 @@ uint16_t MFM::calculateCRC(uint8_t *array, uint8_t len) {
     return _crc;
 }
 
-void MFM::flush(unsigned long _flushtime) {
+uint16_t MFM::transaction(uint8_t *MFMarr, uint16_t reg, uint8_t node, uint16_t _turnaround, uint16_t _timeout, uint8_t count) {
+    unsigned long resptime;
+    uint16_t readErr = MFM_ERR_NO_ERROR;
+    uint8_t replysize = MFM_REPLY_SIZE(count);
+    uint8_t rxlen = 0;
+    bool parity = false;
+
+    buildRequest(MFMarr, reg, node, count);
+
+    flush();                                                                      //read serial if any old data is available
+
+#if !defined ( USE_HARDWARESERIAL )
+    MFMSer.overflow();                                                            //clear overflow flag left by previous data
+#endif
+
+    dereSet(HIGH);                                                                //transmit to MFM  -> DE Enable, /RE Disable (for control MAX485)
+
+    delay(2);                                                                     //fix for issue (nan reading) by sjfaustino: https://github.com/reaper7/MFM_Energy_Meter/issues/7#issuecomment-272111524
+
+    MFMSer.write(MFMarr, FRAMESIZE - 1);                                          //send 8 bytes
+
+    MFMSer.flush();                                                               //clear out tx buffer
+
+    dereSet(LOW);                                                                 //receive from MFM -> DE Disable, /RE Enable (for control MAX485)
+
+    resptime = millis();
+
+    while (rxlen < replysize) {
+        if (MFMSer.available()) {
+#if !defined ( USE_HARDWARESERIAL ) && ( defined ( ESP8266 ) || defined ( ESP32 ) )
+            if (MFMSer.peekParityError())
+                parity = true;
+#endif
+            MFMarr[rxlen++] = MFMSer.read();
+            if (rxlen == MFM_EXCEPTION_SIZE && MFMarr[1] == (MFM_B_02 | 0x80))          //exception reply is shorter than any value reply
+                break;
+            continue;
+        }
+        if (millis() - resptime > _turnaround) {
+            readErr = MFM_ERR_TIMEOUT;                                                //err debug (4)
+            break;
+        }
+        yield();
+    }
+
+    lastresptime = millis() - resptime;
+    lastrxbytes = rxlen + MFMSer.available();
+
+    if (readErr == MFM_ERR_NO_ERROR) {                                            //if no timeout...
+        if (parity)
+            readErr = MFM_ERR_PARITY;                                                 //err debug (6)
+#if !defined ( USE_HARDWARESERIAL )
+        else if (MFMSer.overflow())
+            readErr = MFM_ERR_OVERRUN;                                                //err debug (5)
+#endif
+        else
+            readErr = checkReply(MFMarr, node, count);                              //err debug (1), (2) or (7)
+    }
+
+    lastrxbytes += flush(_timeout);                                               //read serial if any old data is available and wait for RESPONSE_TIMEOUT (in ms)
+
+    if (MFMSer.available())                                                       //if serial rx buffer (after RESPONSE_TIMEOUT) still contains data then something spam rs485, check node(s) or increase RESPONSE_TIMEOUT
+        readErr = MFM_ERR_TIMEOUT;                                                  //err debug (4) but returned value may be correct
+
+    return (readErr);
+}
+
+void MFM::buildRequest(uint8_t *MFMarr, uint16_t reg, uint8_t node, uint8_t count) {
+    uint16_t temp;
+
+    MFMarr[0] = node;
+    MFMarr[1] = MFM_B_02;
+    MFMarr[2] = highByte(reg);
+    MFMarr[3] = lowByte(reg);
+    MFMarr[4] = MFM_B_05;
+    MFMarr[5] = MFM_B_06 * count;                                                 //number of 16bit registers, 2 per value
+
+    temp = calculateCRC(MFMarr,
+                        FRAMESIZE - 3);                                   //calculate out crc only from first 6 bytes
+
+    MFMarr[6] = lowByte(temp);
+    MFMarr[7] = highByte(temp);
+}
+
+uint16_t MFM::checkReply(uint8_t *MFMarr, uint8_t node, uint8_t count) {
+    uint8_t replysize = MFM_REPLY_SIZE(count);
+
+    if (MFMarr[0] == node && MFMarr[1] == (MFM_B_02 | 0x80)) {                     //exception reply, e.g. register not supported
+        if ((calculateCRC(MFMarr, MFM_EXCEPTION_SIZE - 2)) != ((MFMarr[MFM_EXCEPTION_SIZE - 1] << 8) |
+                                                               MFMarr[MFM_EXCEPTION_SIZE - 2]))
+            return (MFM_ERR_CRC_ERROR);                                               //err debug (1)
+        return (MFM_ERR_EXCEPTION);                                                 //err debug (7)
+    }
+
+    if (MFMarr[0] != node || MFMarr[1] != MFM_B_02 || MFMarr[2] != MFM_REPLY_BYTE_COUNT * count)
+        return (MFM_ERR_WRONG_BYTES);                                               //err debug (2)
+
+    if ((calculateCRC(MFMarr, replysize - 2)) != ((MFMarr[replysize - 1] << 8) |
+                                                  MFMarr[replysize - 2]))         //calculate crc from all but last 2 bytes and compare with received crc
+        return (MFM_ERR_CRC_ERROR);                                                 //err debug (1)
+
+    return (MFM_ERR_NO_ERROR);
+}
+
+void MFM::decodeReply(const uint8_t *MFMarr, uint32_t *raw, uint8_t count) {
+    for (uint8_t i = 0; i < count; i++) {
+        const uint8_t *b = &MFMarr[3 + i * MFM_REPLY_BYTE_COUNT];
+        raw[i] = ((uint32_t)b[0] << 24) | ((uint32_t)b[1] << 16) |              //TODO: CHECK BYTE ORDER OF MFM384
+                 ((uint32_t)b[2] << 8) | b[3];
+    }
+}
+
+uint16_t MFM::flush(unsigned long _flushtime) {
     unsigned long flushstart = millis();
+    uint16_t cnt = 0;
     while (MFMSer.available() || (millis() - flushstart < _flushtime)) {
-        if (MFMSer.available())                                                     //read serial if any old data is available
+        if (MFMSer.available()) {                                                   //read serial if any old data is available
             MFMSer.read();
+            cnt++;
+        }
         delay(1);
     }
+    return (cnt);
+}
+
+void MFM::rxEnable() {
+#if !defined ( USE_HARDWARESERIAL )
+    if (!session)
+        MFMSer.listen();
+#endif
+}
+
+void MFM::rxDisable() {
+#if !defined ( USE_HARDWARESERIAL )
+    if (!session)
+        MFMSer.stopListening();
+#endif
 }
 
 void MFM::dereSet(bool _state) {
@@ -53,6 +53,14 @@
     #endif
 #endif
 
+#if !defined ( MFM_SWSERIAL_BUFFER )
+    #define MFM_SWSERIAL_BUFFER                         64                        //  (only esp) software serial rx buffer, library default, holds one full block reply
+#endif
+
+#if !defined ( MFM_SWSERIAL_ISR_BUFFER )
+    #define MFM_SWSERIAL_ISR_BUFFER                     0                         //  (only esp) software serial isr capture buffer, 0 = library default (rx buffer * bits per char)
+#endif
+
 //  #if !defined ( MFM_RX_PIN ) || !defined ( MFM_TX_PIN )
 //    #error "MFM_RX_PIN and MFM_TX_PIN must be defined in MFM_Config_User.h for Software Serial option)"
 //  #endif
@@ -82,6 +90,30 @@
     #define MFM_MAX_DELAY                               5000                      //  maximum value (in ms) for WAITING_TURNAROUND_DELAY and RESPONSE_TIMEOUT
 #endif
 
+#if !defined ( MFM_INT_DECIMALS )
+    #define MFM_INT_DECIMALS                            3                         //  default decimals for readValInt (V->mV, A->mA, kW->W, kWh->Wh)
+#endif
+
+#if !defined ( DISCOVERY_TURNAROUND_DELAY )
+    #define DISCOVERY_TURNAROUND_DELAY                  30                        //  min time in ms to wait for probe response during discover, after first node found (doubled up to WAITING_TURNAROUND_DELAY when any reply byte received)
+#endif
+
+#if !defined ( DISCOVERY_RESPONSE_TIMEOUT )
+    #define DISCOVERY_RESPONSE_TIMEOUT                  MFM_MIN_DELAY             //  time in ms to drain the bus after each probe during discover
+#endif
+
+#if !defined ( FINGERPRINT_TRIES )
+    #define FINGERPRINT_TRIES                           3                         //  attempts per fingerprint probe, register unsupported only after exception reply or silence on all attempts
+#endif
+
+#if !defined ( MFM_INVENTORY_ADDR )
+    #define MFM_INVENTORY_ADDR                          0                         //  eeprom/flash address where node inventory is stored
+#endif
+
+#if !defined ( MFM_INVENTORY_MAX_NODES )
+    #define MFM_INVENTORY_MAX_NODES                     16                        //  maximum number of nodes stored in inventory
+#endif
+
 //------------------------------------------------------------------------------
 
 #define MFM_ERR_NO_ERROR                              0                         //  no error
@@ -89,11 +121,35 @@
 #define MFM_ERR_WRONG_BYTES                           2                         //  bytes b0,b1 or b2 wrong
 #define MFM_ERR_NOT_ENOUGHT_BYTES                     3                         //  not enough bytes from MFM
 #define MFM_ERR_TIMEOUT                               4                         //  timeout
+#define MFM_ERR_OVERRUN                               5                         //  software serial rx buffer overflow, bytes lost
+#define MFM_ERR_PARITY                                6                         //  software serial parity error (esp, uart config with parity)
+#define MFM_ERR_EXCEPTION                             7                         //  modbus exception reply from node (e.g. register not supported)
+
+//------------------------------------------------------------------------------
+
+#define MFM_INT_NAN                                   INT32_MIN                 //  returned by readValInt when value could not be read or does not fit
+
+//------------------------------------------------------------------------------
+
+#define MFM_MODEL_630                                 0x01                      //  model bits (columns of registers list below)
+#define MFM_MODEL_230                                 0x02
+#define MFM_MODEL_220                                 0x04
+#define MFM_MODEL_120CT                               0x08
+#define MFM_MODEL_120                                 0x10
+#define MFM_MODEL_72D                                 0x20
+#define MFM_MODEL_72V2                                0x40
+#define MFM_MODEL_ANY                                 0x7F                      //  model unknown, every model possible
+
+#define MFM_INVENTORY_MAGIC                           0x4D                      //  'M', first byte of stored inventory
+#define MFM_INVENTORY_SIZE                            (3 + 4 * MFM_INVENTORY_MAX_NODES + 2) //  magic, count, reserved, nodes, crc
 
 //------------------------------------------------------------------------------
 
 #define FRAMESIZE                                     9                         //  size of out/in array
 #define MFM_REPLY_BYTE_COUNT                          0x04                      //  number of bytes with data
+#define MFM_MAX_BLOCK                                 12                        //  max values read with one request (reply must fit in uart rx buffer)
+#define MFM_REPLY_SIZE(count)                         (FRAMESIZE - MFM_REPLY_BYTE_COUNT + (count) * MFM_REPLY_BYTE_COUNT)  //  address, function, byte count, crc + 4 bytes per value
+#define MFM_EXCEPTION_SIZE                            5                         //  modbus exception reply: address, function | 0x80, code, crc
 
 #define MFM_B_01                                      0x01                      //  BYTE 1 -> slave address (default value 1 read from node 1)
 #define MFM_B_02                                      0x04                      //  BYTE 2 -> function code (default value 0x04 read from 3X input registers)
@@ -198,6 +254,12 @@
 
 //-----------------------------------------------------------------------------------------------------------------------------------------------------------
 
+typedef struct {
+  uint8_t node;                                                                 //  slave address
+  uint8_t model;                                                                //  MFM_MODEL_* bits of models matching probed registers
+  uint16_t latency;                                                             //  measured response time in ms
+} MFMNode;
+
 class MFM {
 public:
 #if defined ( USE_HARDWARESERIAL )                                              //  hardware serial
@@ -222,8 +284,19 @@ public:
 
     void begin(void);
 
+#if !defined ( MFM_NO_FLOAT )
     float readVal(uint16_t reg,
                   uint8_t node = MFM_B_01);                       //  read value from register = reg and from deviceId = node
+#endif
+    int32_t readValInt(uint16_t reg, uint8_t node = MFM_B_01,
+                       uint8_t decimals = MFM_INT_DECIMALS);                    //  read value scaled by 10^decimals (default mV, mA, W, Wh...), MFM_INT_NAN on error
+#if !defined ( MFM_NO_FLOAT )
+    uint16_t readValBlock(uint16_t reg, uint8_t count, float *vals,
+                          uint8_t node = MFM_B_01);                             //  read count consecutive values (max MFM_MAX_BLOCK) with one request, return MFM_ERR_* code
+#endif
+    uint16_t readValIntBlock(uint16_t reg, uint8_t count, int32_t *vals,
+                             uint8_t node = MFM_B_01,
+                             uint8_t decimals = MFM_INT_DECIMALS);              //  as readValBlock, values scaled like readValInt
     uint16_t getErrCode(
             bool _clear = false);                                   //  return last errorcode (optional clear this value, default flase)
     uint32_t getErrCount(
@@ -241,6 +314,25 @@ public:
     getMsTurnaround();                                                 //  get current value of WAITING_TURNAROUND_DELAY (ms)
     uint16_t
     getMsTimeout();                                                    //  get current value of RESPONSE_TIMEOUT (ms)
+    static uint16_t calculateCRC(uint8_t *array, uint8_t len);                  //  modbus crc16
+    static int32_t floatToInt(uint32_t raw,
+                              uint8_t decimals = MFM_INT_DECIMALS);             //  convert ieee754 bits to value * 10^decimals using integer arithmetic only
+    static void buildRequest(uint8_t *MFMarr, uint16_t reg, uint8_t node,
+                             uint8_t count = 1);                                //  fill 8 byte request frame for count values (also used by other transports)
+    static uint16_t checkReply(uint8_t *MFMarr, uint8_t node,
+                               uint8_t count = 1);                              //  check MFM_REPLY_SIZE(count) byte reply or MFM_EXCEPTION_SIZE byte exception, return MFM_ERR_* code
+    static void decodeReply(const uint8_t *MFMarr, uint32_t *raw,
+                            uint8_t count = 1);                                 //  extract count raw ieee754 values from checked reply
+    void beginSession();                                                        //  keep software serial listening for following readings (poll plan), no-op for hardware serial
+    void endSession();                                                          //  stop listening after poll plan
+    bool inSession();
+    uint8_t discover(MFMNode *nodes, uint8_t maxnodes,
+                     uint8_t firstnode = 1, uint8_t lastnode = 247);          //  probe nodes firstnode..lastnode, fill nodes with responders, return number of found nodes
+    uint8_t fingerprint(uint8_t node, uint16_t latency = 0);                    //  return MFM_MODEL_* bits matching registers supported by node
+#if defined ( MFM_USE_EEPROM )
+    bool saveInventory(const MFMNode *nodes, uint8_t count);                    //  store nodes at MFM_INVENTORY_ADDR in eeprom/flash
+    uint8_t loadInventory(MFMNode *nodes, uint8_t maxnodes);                    //  load nodes from eeprom/flash, return number of nodes (0 if nothing valid stored)
+#endif
 
 private:
 #if defined ( USE_HARDWARESERIAL )
@@ -266,14 +358,24 @@ private:
 #endif
     long _baud = MFM_UART_BAUD;
     int _dere_pin = DERE_PIN;
-    uint16_t readingerrcode = MFM_ERR_NO_ERROR;                                 //  4 = timeout; 3 = not enough bytes; 2 = number of bytes OK but bytes b0,b1 or b2 wrong, 1 = crc error
+    uint16_t readingerrcode = MFM_ERR_NO_ERROR;                                 //  7 = exception reply; 6 = parity error; 5 = rx overflow; 4 = timeout; 3 = not enough bytes; 2 = number of bytes OK but bytes b0,b1 or b2 wrong, 1 = crc error
     uint16_t msturnaround = WAITING_TURNAROUND_DELAY;
     uint16_t mstimeout = RESPONSE_TIMEOUT;
     uint32_t readingerrcount = 0;                                               //  total errors counter
     uint32_t readingsuccesscount = 0;                                           //  total success counter
-    uint16_t calculateCRC(uint8_t *array, uint8_t len);
-
-    void flush(unsigned long _flushtime = 0);                                   //  read serial if any old data is available or for a given time in ms
+    bool session = false;                                                       //  software serial kept listening between readings
+    uint16_t lastresptime = 0;                                                  //  response time in ms of last transaction
+    uint16_t lastrxbytes = 0;                                                   //  number of bytes received in last transaction (including bytes drained after deadline)
+
+    uint16_t readRaw(uint16_t reg, uint8_t node, uint32_t *raw,
+                     uint8_t count = 1);                                        //  read ieee754 bits of count registers, update error/success counters
+    uint16_t transaction(uint8_t *MFMarr, uint16_t reg, uint8_t node,
+                         uint16_t _turnaround, uint16_t _timeout,
+                         uint8_t count = 1);                                    //  send request for count values and receive reply into MFMarr, return MFM_ERR_* code
+
+    uint16_t flush(unsigned long _flushtime = 0);                               //  read serial if any old data is available or for a given time in ms, return number of bytes read
+    void rxEnable();                                                            //  listen on software serial unless in session
+    void rxDisable();                                                           //  stop listening on software serial unless in session
     void dereSet(bool _state = LOW);                                            //  for control MAX485 DE/RE pins, LOW receive from MFM, HIGH transmit to MFM
 };
 
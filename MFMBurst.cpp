@@ -0,0 +1,160 @@
+/* Triggered burst capture for MFM meters.
+*  Polls per-phase voltages and currents with one block request at the maximum rate
+*  the bus allows, keeps a pre-trigger ring and freezes a pre/post window
+*  when a threshold or rate-of-change trigger fires.
+*/
+//------------------------------------------------------------------------------
+#include "MFMBurst.h"
+//------------------------------------------------------------------------------
+#define MFM_BURST_RING                                (MFM_BURST_PRE + MFM_BURST_POST)
+
+MFMBurst::MFMBurst(MFM &mfm, uint8_t node) : _mfm(mfm) {
+    this->_node = node;
+}
+
+void MFMBurst::setVoltageLimits(int32_t _sag, int32_t _swell) {
+    sag = _sag;
+    swell = _swell;
+}
+
+void MFMBurst::setCurrentLimit(int32_t _overcurrent) {
+    overcurrent = _overcurrent;
+}
+
+void MFMBurst::setStepLimits(int32_t _vstep, int32_t _istep) {
+    vstep = _vstep;
+    istep = _istep;
+}
+
+bool MFMBurst::arm(uint32_t duration) {
+    if (state == MFM_BURST_CAPTURE || state == MFM_BURST_FROZEN)                  //event being captured or not uploaded yet
+        return (false);
+
+    if (state == MFM_BURST_IDLE) {
+        savedtimeout = _mfm.getMsTimeout();
+        _mfm.setMsTimeout(BURST_RESPONSE_TIMEOUT);                                  //only one master and one request in flight, no need to wait for other nodes
+    }
+
+    head = 0;
+    fill = 0;
+    haslast = false;
+    cause = 0;
+    armtime = millis();
+    armduration = duration;
+    state = MFM_BURST_ARMED;
+
+    return (true);
+}
+
+void MFMBurst::disarm() {
+    if (state == MFM_BURST_ARMED || state == MFM_BURST_CAPTURE) {
+        stop();
+        state = MFM_BURST_IDLE;
+    }
+}
+
+uint8_t MFMBurst::poll() {
+    int32_t vals[MFM_BURST_BLOCK_COUNT];
+    MFMBurstSample s;
+
+    if (state != MFM_BURST_ARMED && state != MFM_BURST_CAPTURE)
+        return (state);
+
+    if (state == MFM_BURST_ARMED && armduration && millis() - armtime > armduration) {
+        disarm();
+        return (state);
+    }
+
+    if (_mfm.readValIntBlock(MFM_BURST_BLOCK_REG, MFM_BURST_BLOCK_COUNT, vals, _node) != MFM_ERR_NO_ERROR)
+        return (state);                                                             //sample lost, error counted by MFM
+
+    s.ms = millis();
+    for (uint8_t p = 0; p < 3; p++) {
+        s.v[p] = vals[(MFM_VOLTAGE_V1N - MFM_BURST_BLOCK_REG) / 2 + p];
+        s.i[p] = vals[(MFM_CURRENT_I1 - MFM_BURST_BLOCK_REG) / 2 + p];
+    }
+
+    ring[head] = s;
+    if (fill < MFM_BURST_RING)
+        fill++;
+
+    if (state == MFM_BURST_ARMED) {
+        cause = check(s);
+        if (cause) {
+            uint16_t pre = (fill < MFM_BURST_PRE) ? fill : MFM_BURST_PRE;           //post samples overwrite only samples older than pre window
+            evstart = (head + MFM_BURST_RING - (pre - 1)) % MFM_BURST_RING;
+            evtrig = pre - 1;
+            evsize = pre;
+            post = MFM_BURST_POST;
+            state = MFM_BURST_CAPTURE;
+        }
+    } else {
+        evsize++;
+        if (--post == 0) {
+            stop();
+            state = MFM_BURST_FROZEN;
+        }
+    }
+
+    head = (head + 1) % MFM_BURST_RING;
+    last = s;
+    haslast = true;
+
+    return (state);
+}
+
+bool MFMBurst::active() {
+    return (state == MFM_BURST_ARMED || state == MFM_BURST_CAPTURE);
+}
+
+uint8_t MFMBurst::getState() {
+    return (state);
+}
+
+uint8_t MFMBurst::getCause() {
+    return (cause);
+}
+
+uint16_t MFMBurst::eventSize() {
+    return (state == MFM_BURST_FROZEN ? evsize : 0);
+}
+
+uint16_t MFMBurst::eventTrigger() {
+    return (evtrig);
+}
+
+const MFMBurstSample &MFMBurst::eventSample(uint16_t idx) {
+    return (ring[(evstart + idx) % MFM_BURST_RING]);
+}
+
+void MFMBurst::release() {
+    if (state == MFM_BURST_FROZEN)
+        state = MFM_BURST_IDLE;
+}
+
+uint8_t MFMBurst::check(const MFMBurstSample &s) {
+    uint8_t res = 0;
+
+    for (uint8_t p = 0; p < 3; p++) {
+        if (s.v[p] != MFM_INT_NAN) {
+            if (sag && s.v[p] < sag)
+                res |= MFM_BURST_SAG;
+            if (swell && s.v[p] > swell)
+                res |= MFM_BURST_SWELL;
+            if (vstep && haslast && last.v[p] != MFM_INT_NAN && labs(s.v[p] - last.v[p]) > vstep)
+                res |= MFM_BURST_VOLTAGE_STEP;
+        }
+        if (s.i[p] != MFM_INT_NAN) {
+            if (overcurrent && s.i[p] > overcurrent)
+                res |= MFM_BURST_OVERCURRENT;
+            if (istep && haslast && last.i[p] != MFM_INT_NAN && labs(s.i[p] - last.i[p]) > istep)
+                res |= MFM_BURST_CURRENT_STEP;
+        }
+    }
+
+    return (res);
+}
+
+void MFMBurst::stop() {
+    _mfm.setMsTimeout(savedtimeout);
+}
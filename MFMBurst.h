@@ -0,0 +1,96 @@
+/* Triggered burst capture for MFM meters.
+*  Polls per-phase voltages and currents with one block request at the maximum rate
+*  the bus allows, keeps a pre-trigger ring and freezes a pre/post window
+*  when a threshold or rate-of-change trigger fires.
+*/
+//------------------------------------------------------------------------------
+#ifndef MFMBurst_h
+#define MFMBurst_h
+//------------------------------------------------------------------------------
+#include <MFM.h>
+//------------------------------------------------------------------------------
+//DEFAULT CONFIG (DO NOT CHANGE ANYTHING!!! for changes use MFM_Config_User.h):
+//------------------------------------------------------------------------------
+#if !defined ( MFM_BURST_PRE )
+    #define MFM_BURST_PRE                               32                        //  samples kept before trigger (including trigger sample)
+#endif
+
+#if !defined ( MFM_BURST_POST )
+    #define MFM_BURST_POST                              32                        //  samples captured after trigger
+#endif
+
+#if !defined ( BURST_RESPONSE_TIMEOUT )
+    #define BURST_RESPONSE_TIMEOUT                      MFM_MIN_DELAY             //  RESPONSE_TIMEOUT used while burst is active
+#endif
+//------------------------------------------------------------------------------
+
+#define MFM_BURST_IDLE                                0                         //  not polling
+#define MFM_BURST_ARMED                               1                         //  polling, filling pre-trigger ring
+#define MFM_BURST_CAPTURE                             2                         //  triggered, capturing post-trigger samples
+#define MFM_BURST_FROZEN                              3                         //  event window ready, call release() after upload
+
+#define MFM_BURST_SAG                                 0x01                      //  trigger causes
+#define MFM_BURST_SWELL                               0x02
+#define MFM_BURST_OVERCURRENT                         0x04
+#define MFM_BURST_VOLTAGE_STEP                        0x08
+#define MFM_BURST_CURRENT_STEP                        0x10
+
+#define MFM_BURST_BLOCK_REG                           MFM_VOLTAGE_V1N           //  MFM_VOLTAGE_V1N..MFM_CURRENT_I3 read with one request
+#define MFM_BURST_BLOCK_COUNT                         ((MFM_CURRENT_I3 - MFM_VOLTAGE_V1N) / 2 + 1)
+
+//------------------------------------------------------------------------------
+
+typedef struct {
+  uint32_t ms;                                                                  //  millis() of sample
+  int32_t v[3];                                                                 //  MFM_VOLTAGE_V1N..V3N in mV
+  int32_t i[3];                                                                 //  MFM_CURRENT_I1..I3 in mA
+} MFMBurstSample;
+
+class MFMBurst {
+public:
+    MFMBurst(MFM &mfm, uint8_t node = MFM_B_01);
+
+    void setVoltageLimits(int32_t sag, int32_t swell);                          //  trigger when any phase voltage (mV) below sag or above swell, 0 = disabled
+    void setCurrentLimit(int32_t overcurrent);                                  //  trigger when any phase current (mA) above overcurrent, 0 = disabled
+    void setStepLimits(int32_t vstep, int32_t istep);                           //  trigger when voltage (mV) / current (mA) changes more between two samples, 0 = disabled
+
+    bool arm(uint32_t duration = 0);                                            //  (re)start burst polling for duration ms (0 = until trigger), false while capturing or event not released
+    void disarm();                                                              //  stop burst polling, back to normal scheduling
+    uint8_t poll();                                                             //  call from loop, reads one sample when armed, return MFM_BURST_* state
+    bool active();                                                              //  true when burst owns the bus (armed or capturing)
+
+    uint8_t getState();
+    uint8_t getCause();                                                         //  MFM_BURST_* trigger cause bits of frozen event
+    uint16_t eventSize();                                                       //  number of samples in frozen event
+    uint16_t eventTrigger();                                                    //  index of trigger sample in event
+    const MFMBurstSample &eventSample(uint16_t idx);                            //  event samples in chronological order
+    void release();                                                             //  free event after upload
+
+private:
+    MFM &_mfm;
+    uint8_t _node;
+    MFMBurstSample ring[MFM_BURST_PRE + MFM_BURST_POST];                        //  preallocated pre-trigger ring and post-trigger window
+    MFMBurstSample last;                                                        //  previous sample for step triggers
+    bool haslast = false;
+    uint16_t head = 0;                                                          //  next ring index to write
+    uint16_t fill = 0;                                                          //  valid samples in ring
+    uint16_t post = 0;                                                          //  post-trigger samples left
+    uint16_t evstart = 0;                                                       //  ring index of first event sample
+    uint16_t evsize = 0;
+    uint16_t evtrig = 0;
+    uint8_t state = MFM_BURST_IDLE;
+    uint8_t cause = 0;
+    uint16_t savedtimeout = RESPONSE_TIMEOUT;
+    uint32_t armtime = 0;
+    uint32_t armduration = 0;
+    int32_t sag = 0;
+    int32_t swell = 0;
+    int32_t overcurrent = 0;
+    int32_t vstep = 0;
+    int32_t istep = 0;
+
+    uint8_t check(const MFMBurstSample &s);                                     //  return trigger cause bits for sample
+    void stop();                                                                //  restore RESPONSE_TIMEOUT
+};
+
+#endif // MFMBurst_h
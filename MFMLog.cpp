@@ -0,0 +1,488 @@
+/* Persistent snapshot log for MFM readings.
+*  Append-only log of small binary records, batched into pages with crc,
+*  stored in segment files so consumed data is freed by removing whole files.
+*  Storage backend is abstract: LittleFS on esp (MFM_USE_LITTLEFS), plain files (stdio) elsewhere.
+*/
+//------------------------------------------------------------------------------
+#include "MFMLog.h"
+#include <stdlib.h>
+//------------------------------------------------------------------------------
+#if defined ( MFM_LOG_LITTLEFS ) || !defined ( ARDUINO )
+static const char *splitPrefix(const char *prefix, char *dir, const char *cwd) {  //split prefix into directory and file name base, NULL if too long
+    const char *base = strrchr(prefix, '/');
+    if (strlen(prefix) + 15 > MFM_LOG_PATH_SIZE - 1)                              //room for longest segment file name: 10 digits + ".log"
+        return (NULL);
+    if (!base) {
+        snprintf(dir, MFM_LOG_PATH_SIZE, "%s", cwd);
+        return (prefix);
+    }
+    snprintf(dir, MFM_LOG_PATH_SIZE, "%.*s", base == prefix ? 1 : (int)(base - prefix), prefix);
+    return (base + 1);
+}
+
+static bool segNumber(const char *name, const char *base, uint32_t &seg) {     //parse <base><seg>.log
+    size_t n = strlen(base);
+    char *end;
+    if (strncmp(name, base, n) != 0 || name[n] < '0' || name[n] > '9')
+        return (false);
+    seg = strtoul(&name[n], &end, 10);
+    return (strcmp(end, ".log") == 0);
+}
+
+static void segRange(uint32_t seg, uint32_t &first, uint32_t &last, int32_t &count) {
+    if (count == 0 || seg < first)
+        first = seg;
+    if (count == 0 || seg > last)
+        last = seg;
+    count++;
+}
+#endif
+//------------------------------------------------------------------------------
+#if defined ( MFM_LOG_LITTLEFS )
+MFMLogLittleFS::MFMLogLittleFS(const char *prefix) : _prefix(prefix) {
+}
+
+int32_t MFMLogLittleFS::size(uint32_t seg) {
+    char p[MFM_LOG_PATH_SIZE];
+    path(p, seg);
+    if (!LittleFS.exists(p))
+        return (-1);
+    File f = LittleFS.open(p, "r");
+    if (!f)
+        return (-1);
+    int32_t res = f.size();
+    f.close();
+    return (res);
+}
+
+bool MFMLogLittleFS::append(uint32_t seg, const uint8_t *buf, uint16_t len) {
+    char p[MFM_LOG_PATH_SIZE];
+    path(p, seg);
+    File f = LittleFS.open(p, "a");
+    if (!f)
+        return (false);
+    size_t n = f.write(buf, len);
+    f.close();                                                                    //littlefs commits appended data atomically on close
+    return (n == len);
+}
+
+bool MFMLogLittleFS::read(uint32_t seg, uint32_t offset, uint8_t *buf, uint16_t len) {
+    char p[MFM_LOG_PATH_SIZE];
+    path(p, seg);
+    File f = LittleFS.open(p, "r");
+    if (!f)
+        return (false);
+    size_t n = 0;
+    if (f.seek(offset, SeekSet))
+        n = f.read(buf, len);
+    f.close();
+    return (n == len);
+}
+
+bool MFMLogLittleFS::remove(uint32_t seg) {
+    char p[MFM_LOG_PATH_SIZE];
+    path(p, seg);
+    return (!LittleFS.exists(p) || LittleFS.remove(p));
+}
+
+int32_t MFMLogLittleFS::list(uint32_t &first, uint32_t &last) {
+    char dir[MFM_LOG_PATH_SIZE];
+    const char *base = splitPrefix(_prefix, dir, "/");
+    uint32_t seg;
+    int32_t count = 0;
+
+    if (!base)
+        return (-1);
+#if defined ( ESP8266 )
+    Dir d = LittleFS.openDir(dir);
+    while (d.next()) {
+        if (segNumber(d.fileName().c_str(), base, seg))
+            segRange(seg, first, last, count);
+    }
+#else
+    File root = LittleFS.open(dir);
+    if (!root || !root.isDirectory())
+        return (-1);
+    for (File f = root.openNextFile(); f; f = root.openNextFile()) {
+        const char *name = strrchr(f.name(), '/');                                  //older cores return full path
+        if (segNumber(name ? name + 1 : f.name(), base, seg))
+            segRange(seg, first, last, count);
+    }
+#endif
+
+    return (count);
+}
+
+bool MFMLogLittleFS::readMeta(uint8_t *buf, uint16_t len) {
+    char p[MFM_LOG_PATH_SIZE];
+    snprintf(p, sizeof(p), "%s.meta", _prefix);
+    File f = LittleFS.open(p, "r");
+    if (!f)
+        return (false);
+    size_t n = f.read(buf, len);
+    f.close();
+    return (n == len);
+}
+
+bool MFMLogLittleFS::writeMeta(const uint8_t *buf, uint16_t len) {
+    char p[MFM_LOG_PATH_SIZE];
+    char t[MFM_LOG_PATH_SIZE];
+    snprintf(p, sizeof(p), "%s.meta", _prefix);
+    snprintf(t, sizeof(t), "%s.tmp", _prefix);
+    File f = LittleFS.open(t, "w");
+    if (!f)
+        return (false);
+    size_t n = f.write(buf, len);
+    f.close();
+    return (n == len && LittleFS.rename(t, p));                                   //littlefs replaces old meta atomically
+}
+
+void MFMLogLittleFS::path(char *buf, uint32_t seg) {
+    snprintf(buf, MFM_LOG_PATH_SIZE, "%s%lu.log", _prefix, (unsigned long)seg);
+}
+#elif !defined ( ARDUINO )
+MFMLogFile::MFMLogFile(const char *prefix) : _prefix(prefix) {
+}
+
+int32_t MFMLogFile::size(uint32_t seg) {
+    char p[MFM_LOG_PATH_SIZE];
+    path(p, seg);
+    FILE *f = fopen(p, "rb");
+    if (!f)
+        return (-1);
+    fseek(f, 0, SEEK_END);
+    int32_t res = ftell(f);
+    fclose(f);
+    return (res);
+}
+
+bool MFMLogFile::append(uint32_t seg, const uint8_t *buf, uint16_t len) {
+    char p[MFM_LOG_PATH_SIZE];
+    path(p, seg);
+    FILE *f = fopen(p, "ab");
+    if (!f)
+        return (false);
+    size_t n = fwrite(buf, 1, len, f);
+    return (fclose(f) == 0 && n == len);
+}
+
+bool MFMLogFile::read(uint32_t seg, uint32_t offset, uint8_t *buf, uint16_t len) {
+    char p[MFM_LOG_PATH_SIZE];
+    path(p, seg);
+    FILE *f = fopen(p, "rb");
+    if (!f)
+        return (false);
+    size_t n = 0;
+    if (fseek(f, offset, SEEK_SET) == 0)
+        n = fread(buf, 1, len, f);
+    fclose(f);
+    return (n == len);
+}
+
+bool MFMLogFile::remove(uint32_t seg) {
+    char p[MFM_LOG_PATH_SIZE];
+    path(p, seg);
+    ::remove(p);
+    return (size(seg) < 0);
+}
+
+int32_t MFMLogFile::list(uint32_t &first, uint32_t &last) {
+    char dir[MFM_LOG_PATH_SIZE];
+    const char *base = splitPrefix(_prefix, dir, ".");
+    uint32_t seg;
+    int32_t count = 0;
+
+    if (!base)
+        return (-1);
+    DIR *d = opendir(dir);
+    if (!d)
+        return (-1);
+    for (struct dirent *e = readdir(d); e; e = readdir(d)) {
+        if (segNumber(e->d_name, base, seg))
+            segRange(seg, first, last, count);
+    }
+    closedir(d);
+
+    return (count);
+}
+
+bool MFMLogFile::readMeta(uint8_t *buf, uint16_t len) {
+    char p[MFM_LOG_PATH_SIZE];
+    snprintf(p, sizeof(p), "%s.meta", _prefix);
+    FILE *f = fopen(p, "rb");
+    if (!f)
+        return (false);
+    size_t n = fread(buf, 1, len, f);
+    fclose(f);
+    return (n == len);
+}
+
+bool MFMLogFile::writeMeta(const uint8_t *buf, uint16_t len) {
+    char p[MFM_LOG_PATH_SIZE];
+    char t[MFM_LOG_PATH_SIZE];
+    snprintf(p, sizeof(p), "%s.meta", _prefix);
+    snprintf(t, sizeof(t), "%s.tmp", _prefix);
+    FILE *f = fopen(t, "wb");
+    if (!f)
+        return (false);
+    size_t n = fwrite(buf, 1, len, f);
+    if (fclose(f) != 0 || n != len)
+        return (false);
+    if (::rename(t, p) == 0)                                                      //atomic replace on posix
+        return (true);
+    ::remove(p);                                                                  //windows does not replace existing files
+    return (::rename(t, p) == 0);
+}
+
+void MFMLogFile::path(char *buf, uint32_t seg) {
+    snprintf(buf, MFM_LOG_PATH_SIZE, "%s%lu.log", _prefix, (unsigned long)seg);
+}
+#endif
+//------------------------------------------------------------------------------
+
+MFMLog::MFMLog(MFMLogStorage &storage) : store(storage) {
+}
+
+bool MFMLog::begin(void) {
+    uint8_t meta[8];
+    uint32_t first = 0;
+    uint32_t last = 0;
+    int32_t sz;
+    bool found;
+    int32_t count;
+
+    started = false;
+    count = store.list(first, last);                                              //segments on storage are the truth, meta only holds the reader cursor
+    if (count < 0)                                                                //directory not readable or prefix too long, appending would lose data
+        return (false);
+    found = count > 0;
+
+    persistedseg = first;
+    if (store.readMeta(meta, sizeof(meta)) &&
+        ((meta[1] << 8) | meta[0]) == MFM_LOG_META_MAGIC &&
+        calculateCRC(meta, 6) == ((meta[7] << 8) | meta[6])) {                   //ignore missing or corrupted meta, start at oldest segment
+        uint32_t seg = (uint32_t)meta[2] | ((uint32_t)meta[3] << 8) |
+                       ((uint32_t)meta[4] << 16) | ((uint32_t)meta[5] << 24);
+        if (!found || seg > first)
+            persistedseg = seg;
+    }
+
+    if (found) {
+        for (uint32_t s = first; s < persistedseg && s <= last; s++)               //consumed segments left by reset between meta write and remove
+            store.remove(s);
+    }
+
+    head.seg = (found && last > persistedseg) ? last : persistedseg;
+    head.page = 0;
+    head.off = 0;
+    sz = store.size(head.seg);
+    if (sz > 0) {
+        if ((sz % MFM_LOG_PAGE_SIZE) != 0 ||
+            (sz / MFM_LOG_PAGE_SIZE) >= MFM_LOG_SEGMENT_PAGES) {                  //torn page at the end or full segment, continue in next segment
+            head.seg++;
+        } else {
+            head.page = sz / MFM_LOG_PAGE_SIZE;
+        }
+    }
+
+    cursor.seg = persistedseg;
+    cursor.page = 0;
+    cursor.off = 0;
+    committed = cursor;
+    rpage.seg = 0xFFFFFFFF;
+    wlen = 0;
+    started = true;
+
+    return (true);
+}
+
+bool MFMLog::append(const uint8_t *data, uint8_t len) {
+    if (!started || len > MFM_LOG_MAX_RECORD)
+        return (false);
+
+    if (MFM_LOG_HEADER_SIZE + wlen + 1 + len > MFM_LOG_PAGE_SIZE) {                //no room left in current page
+        if (!writePage())
+            return (false);
+    }
+
+    wbuf[MFM_LOG_HEADER_SIZE + wlen] = len;
+    memcpy(&wbuf[MFM_LOG_HEADER_SIZE + wlen + 1], data, len);
+    wlen += 1 + len;
+
+    return (true);
+}
+
+bool MFMLog::flush() {
+    if (!started)
+        return (false);
+    if (wlen == 0)
+        return (true);
+    return (writePage());
+}
+
+int16_t MFMLog::read(uint8_t *data, uint8_t maxlen) {
+    const uint8_t *src;
+    uint16_t used;
+    uint8_t len;
+
+    if (!started)
+        return (-1);
+
+    while (true) {
+        if (cursor.seg > head.seg || (cursor.seg == head.seg && cursor.page >= head.page)) {  //cursor in page not yet written to storage
+            src = &wbuf[MFM_LOG_HEADER_SIZE];
+            used = wlen;
+            if (cursor.off >= used)
+                return (-1);
+        } else {
+            if (!loadPage(cursor))                                                  //torn or corrupted page, skip it
+                used = 0;
+            else
+                used = rlen;
+            src = &rbuf[MFM_LOG_HEADER_SIZE];
+            if (cursor.off >= used) {
+                cursor.off = 0;
+                if (++cursor.page >= MFM_LOG_SEGMENT_PAGES) {
+                    cursor.seg++;
+                    cursor.page = 0;
+                }
+                continue;
+            }
+        }
+
+        len = src[cursor.off];
+        if (cursor.off + 1 + len > used) {                                          //record length damaged, drop rest of page
+            cursor.off = used;
+            continue;
+        }
+        memcpy(data, &src[cursor.off + 1], len < maxlen ? len : maxlen);
+        cursor.off += 1 + len;
+        return (len);
+    }
+}
+
+void MFMLog::commit() {
+    committed = cursor;
+    if (committed.seg != persistedseg)                                            //persist cursor once per segment, records within segment may be read again after reboot
+        sync();
+}
+
+void MFMLog::rewind() {
+    cursor = committed;
+}
+
+bool MFMLog::sync() {
+    uint8_t meta[8];
+    uint16_t crc;
+
+    meta[0] = MFM_LOG_META_MAGIC & 0xFF;
+    meta[1] = MFM_LOG_META_MAGIC >> 8;
+    meta[2] = committed.seg & 0xFF;
+    meta[3] = (committed.seg >> 8) & 0xFF;
+    meta[4] = (committed.seg >> 16) & 0xFF;
+    meta[5] = (committed.seg >> 24) & 0xFF;
+    crc = calculateCRC(meta, 6);
+    meta[6] = crc & 0xFF;
+    meta[7] = crc >> 8;
+
+    if (!store.writeMeta(meta, sizeof(meta)))
+        return (false);
+
+    for (uint32_t s = persistedseg; s < committed.seg; s++)                       //remove consumed segments only after cursor is stored
+        store.remove(s);
+    persistedseg = committed.seg;
+
+    return (true);
+}
+
+uint32_t MFMLog::backlog() {
+    int32_t n = (int32_t)(head.seg - committed.seg) * MFM_LOG_SEGMENT_PAGES +
+                head.page - committed.page;
+
+    if (n <= 0)
+        return (committed.off < wlen ? 1 : 0);
+    return (n + (wlen > 0 ? 1 : 0));
+}
+
+uint32_t MFMLog::getDropCount(bool _clear) {
+    uint32_t _tmp = dropcount;
+    if (_clear == true)
+        dropcount = 0;
+    return (_tmp);
+}
+
+bool MFMLog::writePage() {
+    uint16_t crc;
+
+    if (committed.seg == head.seg && committed.page == head.page && committed.off >= wlen) {  //page already uploaded from ram, no need to store it
+        cursor.off = 0;
+        committed.off = 0;
+        wlen = 0;
+        return (true);
+    }
+
+    crc = calculateCRC(&wbuf[MFM_LOG_HEADER_SIZE], wlen);
+    wbuf[0] = wlen & 0xFF;
+    wbuf[1] = wlen >> 8;
+    wbuf[2] = crc & 0xFF;
+    wbuf[3] = crc >> 8;
+    memset(&wbuf[MFM_LOG_HEADER_SIZE + wlen], 0xFF, MFM_LOG_PAGE_SIZE - MFM_LOG_HEADER_SIZE - wlen);
+
+    if (!store.append(head.seg, wbuf, MFM_LOG_PAGE_SIZE))
+        return (false);
+
+    wlen = 0;
+    if (++head.page >= MFM_LOG_SEGMENT_PAGES) {
+        head.seg++;
+        head.page = 0;
+        if (head.seg - committed.seg >= MFM_LOG_SEGMENTS)                          //log full, make room for new segment
+            dropOldest();
+    }
+
+    return (true);
+}
+
+bool MFMLog::loadPage(const Cursor &pos) {
+    uint16_t used;
+
+    if (rpage.seg == pos.seg && rpage.page == pos.page)
+        return (true);
+
+    rpage.seg = 0xFFFFFFFF;
+    if (!store.read(pos.seg, (uint32_t)pos.page * MFM_LOG_PAGE_SIZE, rbuf, MFM_LOG_PAGE_SIZE))
+        return (false);
+
+    used = (rbuf[1] << 8) | rbuf[0];
+    if (used > MFM_LOG_PAGE_SIZE - MFM_LOG_HEADER_SIZE ||
+        calculateCRC(&rbuf[MFM_LOG_HEADER_SIZE], used) != ((rbuf[3] << 8) | rbuf[2]))
+        return (false);
+
+    rpage = pos;
+    rlen = used;
+    return (true);
+}
+
+void MFMLog::dropOldest() {
+    committed.seg++;
+    committed.page = 0;
+    committed.off = 0;
+    if (cursor.seg < committed.seg)
+        cursor = committed;
+    dropcount++;
+    sync();                                                                       //removes dropped segment
+}
+
+uint16_t MFMLog::calculateCRC(const uint8_t *array, uint16_t len) {
+    uint16_t _crc, _flag;
+    _crc = 0xFFFF;
+    for (uint16_t i = 0; i < len; i++) {
+        _crc ^= (uint16_t) array[i];
+        for (uint8_t j = 8; j; j--) {
+            _flag = _crc & 0x0001;
+            _crc >>= 1;
+            if (_flag)
+                _crc ^= 0xA001;
+        }
+    }
+    return _crc;
+}
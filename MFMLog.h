@@ -0,0 +1,160 @@
+/* Persistent snapshot log for MFM readings.
+*  Append-only log of small binary records, batched into pages with crc,
+*  stored in segment files so consumed data is freed by removing whole files.
+*  Storage backend is abstract: LittleFS on esp (MFM_USE_LITTLEFS), plain files (stdio) elsewhere.
+*/
+//------------------------------------------------------------------------------
+#ifndef MFMLog_h
+#define MFMLog_h
+//------------------------------------------------------------------------------
+#include <stdint.h>
+#include <string.h>
+
+#if defined ( ARDUINO )
+    #include <MFM_Config_User.h>
+#endif
+
+#if ( defined ( ESP8266 ) || defined ( ESP32 ) ) && defined ( MFM_USE_LITTLEFS )
+    #define MFM_LOG_LITTLEFS                                                    //  LittleFS backend enabled in MFM_Config_User.h (esp8266 core >= 2.6, esp32 core >= 2.0)
+#endif
+
+#if defined ( MFM_LOG_LITTLEFS )
+    #include <LittleFS.h>
+#elif !defined ( ARDUINO )
+    #include <stdio.h>
+    #include <dirent.h>
+#endif
+//------------------------------------------------------------------------------
+//DEFAULT CONFIG (DO NOT CHANGE ANYTHING!!! for changes use MFM_Config_User.h):
+//------------------------------------------------------------------------------
+#if !defined ( MFM_LOG_PAGE_SIZE )                                              //  bytes written to flash at once (page header + records), two pages are kept in ram
+    #if defined ( ESP8266 )
+        #define MFM_LOG_PAGE_SIZE                       8192                      //  littlefs block size, appends never copy a partly filled block
+    #elif defined ( ESP32 )
+        #define MFM_LOG_PAGE_SIZE                       4096                      //  littlefs block size, appends never copy a partly filled block
+    #else
+        #define MFM_LOG_PAGE_SIZE                       256
+    #endif
+#endif
+
+#if !defined ( MFM_LOG_SEGMENT_PAGES )                                          //  pages per segment file
+    #if defined ( ESP8266 )
+        #define MFM_LOG_SEGMENT_PAGES                   2
+    #elif defined ( ESP32 )
+        #define MFM_LOG_SEGMENT_PAGES                   4
+    #else
+        #define MFM_LOG_SEGMENT_PAGES                   16
+    #endif
+#endif
+
+#if !defined ( MFM_LOG_SEGMENTS )
+    #define MFM_LOG_SEGMENTS                            16                        //  max segment files, oldest dropped when exceeded
+#endif
+//------------------------------------------------------------------------------
+
+#define MFM_LOG_HEADER_SIZE                           4                         //  page header: used bytes (2), crc (2)
+#define MFM_LOG_MAX_RECORD                            (MFM_LOG_PAGE_SIZE - MFM_LOG_HEADER_SIZE - 1 < 255 ? \
+                                                       MFM_LOG_PAGE_SIZE - MFM_LOG_HEADER_SIZE - 1 : 255)  //  max record length
+#define MFM_LOG_META_MAGIC                            0x4D4C                    //  'ML'
+
+#if defined ( ESP8266 ) || defined ( ESP32 )
+    #define MFM_LOG_PATH_SIZE                           64                        //  max path length of segment and meta files (prefix + 14)
+#else
+    #define MFM_LOG_PATH_SIZE                           256
+#endif
+
+//------------------------------------------------------------------------------
+
+class MFMLogStorage {                                                           //  segment files backend
+public:
+    virtual ~MFMLogStorage() {}
+    virtual int32_t size(uint32_t seg) = 0;                                     //  size of segment in bytes, -1 if not exists
+    virtual bool append(uint32_t seg, const uint8_t *buf, uint16_t len) = 0;    //  append to segment (create if not exists)
+    virtual bool read(uint32_t seg, uint32_t offset, uint8_t *buf, uint16_t len) = 0;
+    virtual bool remove(uint32_t seg) = 0;
+    virtual int32_t list(uint32_t &first, uint32_t &last) = 0;                  //  number of segments and lowest/highest one, -1 if directory not readable
+    virtual bool readMeta(uint8_t *buf, uint16_t len) = 0;                      //  small meta record (reader cursor)
+    virtual bool writeMeta(const uint8_t *buf, uint16_t len) = 0;
+};
+
+#if defined ( MFM_LOG_LITTLEFS )
+class MFMLogLittleFS : public MFMLogStorage {                                   //  LittleFS must be mounted (LittleFS.begin()) before MFMLog::begin
+public:
+    MFMLogLittleFS(const char *prefix = "/mfmlog");                             //  files: <prefix><seg>.log and <prefix>.meta
+
+    int32_t size(uint32_t seg);
+    bool append(uint32_t seg, const uint8_t *buf, uint16_t len);
+    bool read(uint32_t seg, uint32_t offset, uint8_t *buf, uint16_t len);
+    bool remove(uint32_t seg);
+    int32_t list(uint32_t &first, uint32_t &last);
+    bool readMeta(uint8_t *buf, uint16_t len);
+    bool writeMeta(const uint8_t *buf, uint16_t len);                           //  written to <prefix>.tmp and renamed, never torn
+
+private:
+    const char *_prefix;
+    void path(char *buf, uint32_t seg);
+};
+#elif !defined ( ARDUINO )
+class MFMLogFile : public MFMLogStorage {                                       //  plain files, for testing and benchmarking on a pc
+public:
+    MFMLogFile(const char *prefix);                                             //  files: <prefix><seg>.log and <prefix>.meta
+
+    int32_t size(uint32_t seg);
+    bool append(uint32_t seg, const uint8_t *buf, uint16_t len);
+    bool read(uint32_t seg, uint32_t offset, uint8_t *buf, uint16_t len);
+    bool remove(uint32_t seg);
+    int32_t list(uint32_t &first, uint32_t &last);
+    bool readMeta(uint8_t *buf, uint16_t len);
+    bool writeMeta(const uint8_t *buf, uint16_t len);                           //  written to <prefix>.tmp and renamed, never torn
+
+private:
+    const char *_prefix;
+    void path(char *buf, uint32_t seg);
+};
+#endif
+
+class MFMLog {
+public:
+    MFMLog(MFMLogStorage &storage);
+
+    bool begin(void);                                                           //  recover write position from existing segments and reader cursor from meta,
+                                                                                //  false (log unusable) when segments can not be listed
+
+    bool append(const uint8_t *data, uint8_t len);                              //  add record, page is written to storage when full
+    bool flush();                                                               //  write current (partial) page to storage, e.g. before deep sleep
+
+    int16_t read(uint8_t *data, uint8_t maxlen);                                //  read next record after cursor, return length or -1 when no more records
+    void commit();                                                              //  mark records read so far as consumed (uploaded)
+    void rewind();                                                              //  move cursor back to last commit (upload failed)
+    bool sync();                                                                //  persist committed cursor now
+
+    uint32_t backlog();                                                         //  number of pages (including current) not yet committed
+    uint32_t getDropCount(bool _clear = false);                                 //  return number of segments dropped because log was full
+
+private:
+    struct Cursor {
+        uint32_t seg;
+        uint16_t page;
+        uint16_t off;
+    };
+
+    MFMLogStorage &store;
+    uint8_t wbuf[MFM_LOG_PAGE_SIZE];                                            //  page being filled
+    uint8_t rbuf[MFM_LOG_PAGE_SIZE];                                            //  last page read from storage
+    uint16_t wlen = 0;                                                          //  used payload bytes in wbuf
+    uint16_t rlen = 0;                                                          //  used payload bytes in rbuf
+    Cursor head = {0, 0, 0};                                                    //  position of wbuf
+    Cursor rpage = {0xFFFFFFFF, 0, 0};                                          //  position of rbuf
+    Cursor cursor = {0, 0, 0};                                                  //  reader position
+    Cursor committed = {0, 0, 0};
+    uint32_t persistedseg = 0;                                                  //  segment of cursor stored in meta
+    uint32_t dropcount = 0;
+    bool started = false;                                                       //  begin() succeeded
+
+    bool writePage();
+    bool loadPage(const Cursor &pos);
+    void dropOldest();
+    static uint16_t calculateCRC(const uint8_t *array, uint16_t len);
+};
+
+#endif // MFMLog_h
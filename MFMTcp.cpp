@@ -0,0 +1,179 @@
+/* Modbus RTU over TCP transport for MFM meters behind Ethernet/WiFi to RS485 gateways.
+*  Sends the same RTU frames as MFM (crc included) over Client connections,
+*  one request in flight per gateway, many gateways polled concurrently.
+*/
+//------------------------------------------------------------------------------
+#include "MFMTcp.h"
+//------------------------------------------------------------------------------
+MFMTcp::MFMTcp(MFMTcpCallback callback) {
+    this->_callback = callback;
+}
+
+int8_t MFMTcp::addGateway(Client &client, IPAddress ip, uint16_t port, uint16_t turnaround) {
+    if (gwcount >= MFM_TCP_MAX_GATEWAYS)
+        return (-1);
+
+    Gateway &g = gateways[gwcount];
+    g.client = &client;
+    g.ip = ip;
+    g.port = port;
+    g.turnaround = turnaround;
+    g.busy = false;
+    g.reqtime = 0;
+    g.conntime = 0;
+    g.rxlen = 0;
+    g.qhead = 0;
+    g.qlen = 0;
+    client.setTimeout(turnaround);                                                //also limits blocking connect on esp
+
+    return (gwcount++);
+}
+
+bool MFMTcp::request(uint8_t gateway, uint16_t reg, uint8_t node, uint8_t count) {
+    if (gateway >= gwcount || count == 0 || count > MFM_MAX_BLOCK)
+        return (false);
+
+    Gateway &g = gateways[gateway];
+    if (g.qlen >= MFM_TCP_QUEUE)
+        return (false);
+
+    Request &r = g.queue[(g.qhead + g.qlen) % MFM_TCP_QUEUE];
+    r.reg = reg;
+    r.node = node;
+    r.count = count;
+    g.qlen++;
+
+    return (true);
+}
+
+void MFMTcp::poll() {
+    bool connecting = false;                                                      //Client::connect() blocks, at most one attempt per poll
+
+    for (uint8_t n = 0; n < gwcount; n++) {
+        pollGateway((pollstart + n) % gwcount, connecting);
+        yield();
+    }
+    if (gwcount)
+        pollstart = (pollstart + 1) % gwcount;                                      //rotate, so every gateway gets its connection attempt
+}
+
+bool MFMTcp::idle() {
+    for (uint8_t i = 0; i < gwcount; i++) {
+        if (gateways[i].qlen)
+            return (false);
+    }
+    return (true);
+}
+
+bool MFMTcp::connected(uint8_t gateway) {
+    return (gateway < gwcount && gateways[gateway].client->connected());
+}
+
+uint16_t MFMTcp::getErrCode(bool _clear) {
+    uint16_t _tmp = readingerrcode;
+    if (_clear == true)
+        readingerrcode = MFM_ERR_NO_ERROR;
+    return (_tmp);
+}
+
+uint32_t MFMTcp::getErrCount(bool _clear) {
+    uint32_t _tmp = readingerrcount;
+    if (_clear == true)
+        readingerrcount = 0;
+    return (_tmp);
+}
+
+uint32_t MFMTcp::getSuccCount(bool _clear) {
+    uint32_t _tmp = readingsuccesscount;
+    if (_clear == true)
+        readingsuccesscount = 0;
+    return (_tmp);
+}
+
+void MFMTcp::pollGateway(uint8_t idx, bool &connecting) {
+    Gateway &g = gateways[idx];
+
+    if (!g.client->connected()) {
+        if (g.busy) {                                                               //connection lost while waiting for reply
+            g.busy = false;
+            finish(idx, MFM_ERR_TIMEOUT);
+        }
+        if (g.qlen == 0)                                                            //connect only when there is something to send
+            return;
+        if (connecting || (g.conntime != 0 && millis() - g.conntime < MFM_TCP_RECONNECT_DELAY))
+            return;
+        connecting = true;
+        g.conntime = millis();
+        g.client->stop();
+        if (!g.client->connect(g.ip, g.port)) {
+            failAll(idx);                                                           //do not keep the poller waiting for unreachable gateway
+            return;
+        }
+    }
+
+    if (!g.busy) {
+        uint8_t frame[FRAMESIZE];
+
+        if (g.qlen == 0)
+            return;
+
+        Request &r = g.queue[g.qhead];
+        while (g.client->available())                                               //drop late reply of previous timed out request
+            g.client->read();
+
+        MFM::buildRequest(frame, r.reg, r.node, r.count);
+        if (g.client->write(frame, FRAMESIZE - 1) != FRAMESIZE - 1) {
+            g.client->stop();
+            finish(idx, MFM_ERR_TIMEOUT);
+            return;
+        }
+        g.busy = true;
+        g.rxlen = 0;
+        g.reqtime = millis();
+        return;
+    }
+
+    Request &r = g.queue[g.qhead];
+    uint8_t replysize = MFM_REPLY_SIZE(r.count);
+
+    while (g.rxlen < replysize && g.client->available())
+        g.rxbuf[g.rxlen++] = g.client->read();
+
+    if (g.rxlen >= MFM_EXCEPTION_SIZE && g.rxbuf[0] == r.node && g.rxbuf[1] == (MFM_B_02 | 0x80)) {  //exception reply, e.g. register not supported
+        g.busy = false;
+        finish(idx, MFM::checkReply(g.rxbuf, r.node, r.count));                     //MFM_ERR_EXCEPTION or MFM_ERR_CRC_ERROR
+    } else if (g.rxlen == replysize) {
+        g.busy = false;
+        finish(idx, MFM::checkReply(g.rxbuf, r.node, r.count));
+    } else if (millis() - g.reqtime > g.turnaround) {
+        g.busy = false;
+        g.client->stop();                                                           //late reply would be taken as reply to next request (rtu reply has no register), drop connection
+        g.conntime = 0;                                                             //reconnect at next poll
+        finish(idx, MFM_ERR_TIMEOUT);
+    }
+}
+
+void MFMTcp::finish(uint8_t idx, uint16_t err) {
+    Gateway &g = gateways[idx];
+    Request r = g.queue[g.qhead];
+    uint32_t raw[MFM_MAX_BLOCK];
+
+    g.qhead = (g.qhead + 1) % MFM_TCP_QUEUE;                                        //remove before callback, so callback can queue next request
+    g.qlen--;
+
+    if (err == MFM_ERR_NO_ERROR) {
+        MFM::decodeReply(g.rxbuf, raw, r.count);
+        ++readingsuccesscount;
+    } else {
+        readingerrcode = err;
+        readingerrcount++;
+    }
+
+    if (_callback)
+        _callback(idx, r.node, r.reg, err, raw, r.count);
+}
+
+void MFMTcp::failAll(uint8_t idx) {
+    for (uint8_t n = gateways[idx].qlen; n; n--)                                  //only requests queued now, callback may add new ones
+        finish(idx, MFM_ERR_TIMEOUT);
+}
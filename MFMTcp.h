@@ -0,0 +1,91 @@
+/* Modbus RTU over TCP transport for MFM meters behind Ethernet/WiFi to RS485 gateways.
+*  Sends the same RTU frames as MFM (crc included) over Client connections,
+*  one request in flight per gateway, many gateways polled concurrently.
+*/
+//------------------------------------------------------------------------------
+#ifndef MFMTcp_h
+#define MFMTcp_h
+//------------------------------------------------------------------------------
+#include <MFM.h>
+#include <Client.h>
+#include <IPAddress.h>
+//------------------------------------------------------------------------------
+//DEFAULT CONFIG (DO NOT CHANGE ANYTHING!!! for changes use MFM_Config_User.h):
+//------------------------------------------------------------------------------
+#if !defined ( MFM_TCP_MAX_GATEWAYS )
+    #define MFM_TCP_MAX_GATEWAYS                        4                         //  max number of gateways
+#endif
+
+#if !defined ( MFM_TCP_QUEUE )
+    #define MFM_TCP_QUEUE                               8                         //  max queued requests per gateway
+#endif
+
+#if !defined ( MFM_TCP_PORT )
+    #define MFM_TCP_PORT                                502                       //  default gateway port
+#endif
+
+#if !defined ( TCP_TURNAROUND_DELAY )
+    #define TCP_TURNAROUND_DELAY                        1000                      //  default time in ms to wait for gateway response (network + bus)
+#endif
+
+#if !defined ( MFM_TCP_RECONNECT_DELAY )
+    #define MFM_TCP_RECONNECT_DELAY                     5000                      //  time in ms between connection attempts
+#endif
+//------------------------------------------------------------------------------
+
+typedef void (*MFMTcpCallback)(uint8_t gateway, uint8_t node, uint16_t reg,
+                               uint16_t err, const uint32_t *raw, uint8_t count);  //  raw ieee754 values, valid when err == MFM_ERR_NO_ERROR
+
+class MFMTcp {
+public:
+    MFMTcp(MFMTcpCallback callback);
+
+    int8_t addGateway(Client &client, IPAddress ip, uint16_t port = MFM_TCP_PORT,
+                      uint16_t turnaround = TCP_TURNAROUND_DELAY);              //  return gateway index, -1 when MFM_TCP_MAX_GATEWAYS reached
+    bool request(uint8_t gateway, uint16_t reg, uint8_t node = MFM_B_01,
+                 uint8_t count = 1);                                            //  queue read of count values, false when queue full
+    void poll();                                                                //  call from loop, drives all gateways, calls callback for finished requests
+                                                                                //  (at most one blocking connect per call, up to gateway turnaround on esp)
+    bool idle();                                                                //  true when no request queued or in flight
+    bool connected(uint8_t gateway);
+
+    uint16_t getErrCode(bool _clear = false);                                   //  return last errorcode (optional clear this value, default false)
+    uint32_t getErrCount(bool _clear = false);                                  //  return total errors count (optional clear this value, default false)
+    uint32_t getSuccCount(bool _clear = false);                                 //  return total success count (optional clear this value, default false)
+
+private:
+    struct Request {
+        uint16_t reg;
+        uint8_t node;
+        uint8_t count;
+    };
+
+    struct Gateway {
+        Client *client;
+        IPAddress ip;
+        uint16_t port;
+        uint16_t turnaround;
+        bool busy;                                                              //  request at queue head sent, waiting for reply
+        unsigned long reqtime;
+        unsigned long conntime;                                                 //  last connection attempt
+        uint8_t rxlen;
+        uint8_t rxbuf[MFM_REPLY_SIZE(MFM_MAX_BLOCK)];
+        Request queue[MFM_TCP_QUEUE];
+        uint8_t qhead;
+        uint8_t qlen;
+    };
+
+    MFMTcpCallback _callback;
+    Gateway gateways[MFM_TCP_MAX_GATEWAYS];
+    uint8_t gwcount = 0;
+    uint8_t pollstart = 0;                                                      //  first gateway polled by next poll()
+    uint16_t readingerrcode = MFM_ERR_NO_ERROR;
+    uint32_t readingerrcount = 0;
+    uint32_t readingsuccesscount = 0;
+
+    void pollGateway(uint8_t idx, bool &connecting);
+    void finish(uint8_t idx, uint16_t err);                                     //  report result of queue head and remove it
+    void failAll(uint8_t idx);                                                  //  report MFM_ERR_TIMEOUT for all queued requests
+};
+
+#endif // MFMTcp_h
@@ -74,6 +74,16 @@
   */
   //#define MFM_UART_CONFIG                   SWSERIAL_8N1
 
+  //----------------------------------------------------------------------------
+
+  /*
+  *  define user MFM_SWSERIAL_BUFFER rx buffer size and MFM_SWSERIAL_ISR_BUFFER isr capture buffer size
+  *  for esp software serial (default 64 as in library, at least one full block reply of 53 bytes;
+  *  isr buffer 0 = library default, rx buffer * bits per char of MFM_UART_CONFIG)
+  */
+  //#define MFM_SWSERIAL_BUFFER               64
+  //#define MFM_SWSERIAL_ISR_BUFFER           0
+
 #endif
 
 //------------------------------------------------------------------------------
@@ -91,3 +101,89 @@
 //#define RESPONSE_TIMEOUT                    500
 
 //------------------------------------------------------------------------------
+
+/*
+*  define MFM_NO_FLOAT to compile out readVal (float) and use only readValInt (scaled int32),
+*  saves flash on AVR when the sketch does not use float elsewhere
+*/
+//#define MFM_NO_FLOAT
+
+//------------------------------------------------------------------------------
+
+/*
+*  define user MFM_INT_DECIMALS default decimals for readValInt (3 -> mV, mA, W, Wh)
+*/
+//#define MFM_INT_DECIMALS                    3
+
+//------------------------------------------------------------------------------
+
+/*
+*  define user DISCOVERY_TURNAROUND_DELAY min time in ms to wait for probe response during discover,
+*  used after the first node was found with full WAITING_TURNAROUND_DELAY
+*  (extended automatically up to WAITING_TURNAROUND_DELAY when any reply byte is received)
+*/
+//#define DISCOVERY_TURNAROUND_DELAY          30
+
+/*
+*  define user FINGERPRINT_TRIES attempts per fingerprint probe register
+*/
+//#define FINGERPRINT_TRIES                   3
+
+//------------------------------------------------------------------------------
+
+/*
+*  define MFM_USE_EEPROM to enable saveInventory/loadInventory (node inventory in eeprom/flash)
+*/
+//#define MFM_USE_EEPROM
+
+/*
+*  define user MFM_INVENTORY_ADDR eeprom/flash address of stored node inventory
+*  (uses MFM_INVENTORY_SIZE bytes, must not overlap eeprom data of the sketch;
+*  on esp call EEPROM.begin() with at least MFM_INVENTORY_ADDR + MFM_INVENTORY_SIZE
+*  when the sketch uses EEPROM too, otherwise saveInventory/loadInventory start it, never end it)
+*/
+//#define MFM_INVENTORY_ADDR                  0
+
+//------------------------------------------------------------------------------
+
+/*
+*  define MFM_USE_LITTLEFS to enable MFMLogLittleFS snapshot log storage on esp
+*  (needs LittleFS: esp8266 core 2.6 or newer, esp32 core 2.0 or newer)
+*/
+//#define MFM_USE_LITTLEFS
+
+/*
+*  define user MFMLog parameters: MFM_LOG_PAGE_SIZE bytes written to flash at once,
+*  MFM_LOG_SEGMENT_PAGES pages per segment file, MFM_LOG_SEGMENTS max segment files
+*  (default page = littlefs block size: 8192 on esp8266 with 2 pages per segment,
+*  4096 on esp32 with 4 pages per segment; smaller pages save ram (2 pages are kept in ram)
+*  but every append then rewrites the partly filled flash block)
+*/
+//#define MFM_LOG_PAGE_SIZE                   4096
+//#define MFM_LOG_SEGMENT_PAGES               4
+//#define MFM_LOG_SEGMENTS                    16
+
+//------------------------------------------------------------------------------
+
+/*
+*  define user MFMBurst parameters: MFM_BURST_PRE samples kept before trigger,
+*  MFM_BURST_POST samples captured after trigger (28 bytes ram per sample),
+*  BURST_RESPONSE_TIMEOUT time in ms used instead of RESPONSE_TIMEOUT while burst is active
+*/
+//#define MFM_BURST_PRE                       32
+//#define MFM_BURST_POST                      32
+//#define BURST_RESPONSE_TIMEOUT              20
+
+//------------------------------------------------------------------------------
+
+/*
+*  define user MFMTcp parameters: MFM_TCP_MAX_GATEWAYS, MFM_TCP_QUEUE queued requests per gateway,
+*  TCP_TURNAROUND_DELAY time in ms to wait for gateway response,
+*  MFM_TCP_RECONNECT_DELAY time in ms between connection attempts
+*/
+//#define MFM_TCP_MAX_GATEWAYS                4
+//#define MFM_TCP_QUEUE                       8
+//#define TCP_TURNAROUND_DELAY                1000
+//#define MFM_TCP_RECONNECT_DELAY             5000
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,75 @@
+//burst capture example: normal reading every READMFMEVERY ms,
+//between normal readings the bus is polled at full rate for voltage sags / current inrush
+
+//REMEMBER! uncomment #define USE_HARDWARESERIAL
+//in MFM_Config_User.h file if you want to use hardware uart
+
+#include <MFM.h>                                                                //import MFM library
+#include <MFMBurst.h>
+
+#define READMFMEVERY  2000                                                      //normal reading every 2000ms
+
+#if defined ( USE_HARDWARESERIAL )                                              //for HWSERIAL
+
+#if defined ( ESP8266 )                                                         //for ESP8266
+MFM MFM(Serial1, MFM_UART_BAUD, NOT_A_PIN, SERIAL_8N1);                                  //config MFM
+#elif defined ( ESP32 )                                                         //for ESP32
+MFM MFM(Serial1, MFM_UART_BAUD, NOT_A_PIN, SERIAL_8N1, MFM_RX_PIN, MFM_TX_PIN);          //config MFM
+#else                                                                           //for AVR
+MFM MFM(Serial1, MFM_UART_BAUD, NOT_A_PIN);                                              //config MFM on Serial1 (if available!)
+#endif
+
+#else                                                                           //for SWSERIAL
+
+#include <SoftwareSerial.h>                                                     //import SoftwareSerial library
+#if defined ( ESP8266 ) || defined ( ESP32 )                                    //for ESP
+SoftwareSerial swSerMFM;                                                        //config SoftwareSerial
+MFM MFM(swSerMFM, MFM_UART_BAUD, NOT_A_PIN, SWSERIAL_8N1, MFM_RX_PIN, MFM_TX_PIN);       //config MFM
+#else                                                                           //for AVR
+SoftwareSerial swSerMFM(MFM_RX_PIN, MFM_TX_PIN);                                //config SoftwareSerial
+MFM MFM(swSerMFM, MFM_UART_BAUD, NOT_A_PIN);                                             //config MFM
+#endif
+
+#endif
+
+MFMBurst burst(MFM);                                                            //burst capture on node MFM_B_01
+
+unsigned long readtime;
+
+void setup() {
+  Serial.begin(115200);                                                         //initialize serial
+  MFM.begin();                                                                  //initialize MFM communication
+
+  burst.setVoltageLimits(207000, 253000);                                       //sag below 207V, swell above 253V (mV)
+  burst.setCurrentLimit(32000);                                                 //inrush above 32A (mA)
+  burst.setStepLimits(10000, 5000);                                             //10V or 5A change between two samples
+}
+
+void loop() {
+  if (!burst.active() && millis() - readtime >= READMFMEVERY) {                 //normal scheduling
+    Serial.print("Power:     ");
+    Serial.print(MFM.readVal(MFM_TOTAL_KW), 3);
+    Serial.println("kW");
+    readtime = millis();
+    burst.arm(READMFMEVERY - 100);                                              //watch the bus until next normal reading
+  }
+
+  if (burst.poll() == MFM_BURST_FROZEN) {                                       //event captured, upload it
+    Serial.print("Event cause: 0x");
+    Serial.println(burst.getCause(), HEX);
+    for (uint16_t i = 0; i < burst.eventSize(); i++) {
+      const MFMBurstSample &s = burst.eventSample(i);
+      Serial.print(i == burst.eventTrigger() ? "* " : "  ");
+      Serial.print(s.ms);
+      for (uint8_t p = 0; p < 3; p++) {
+        Serial.print(' ');
+        Serial.print(s.v[p]);
+        Serial.print("mV ");
+        Serial.print(s.i[p]);
+        Serial.print("mA");
+      }
+      Serial.println();
+    }
+    burst.release();                                                            //back to normal scheduling
+  }
+}
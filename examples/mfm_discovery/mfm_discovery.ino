@@ -0,0 +1,72 @@
+//REMEMBER! uncomment #define USE_HARDWARESERIAL
+//in MFM_Config_User.h file if you want to use hardware uart
+
+//uncomment #define MFM_USE_EEPROM in MFM_Config_User.h file
+//to keep the inventory in eeprom/flash and skip the scan after reboot
+
+#include <MFM.h>                                                                //import MFM library
+
+#if defined ( USE_HARDWARESERIAL )                                              //for HWSERIAL
+
+#if defined ( ESP8266 )                                                         //for ESP8266
+MFM MFM(Serial1, MFM_UART_BAUD, NOT_A_PIN, SERIAL_8N1);                                  //config MFM
+#elif defined ( ESP32 )                                                         //for ESP32
+MFM MFM(Serial1, MFM_UART_BAUD, NOT_A_PIN, SERIAL_8N1, MFM_RX_PIN, MFM_TX_PIN);          //config MFM
+#else                                                                           //for AVR
+MFM MFM(Serial1, MFM_UART_BAUD, NOT_A_PIN);                                              //config MFM on Serial1 (if available!)
+#endif
+
+#else                                                                           //for SWSERIAL
+
+#include <SoftwareSerial.h>                                                     //import SoftwareSerial library
+#if defined ( ESP8266 ) || defined ( ESP32 )                                    //for ESP
+SoftwareSerial swSerMFM;                                                        //config SoftwareSerial
+MFM MFM(swSerMFM, MFM_UART_BAUD, NOT_A_PIN, SWSERIAL_8N1, MFM_RX_PIN, MFM_TX_PIN);       //config MFM
+#else                                                                           //for AVR
+SoftwareSerial swSerMFM(MFM_RX_PIN, MFM_TX_PIN);                                //config SoftwareSerial
+MFM MFM(swSerMFM, MFM_UART_BAUD, NOT_A_PIN);                                             //config MFM
+#endif
+
+#endif
+
+MFMNode nodes[MFM_INVENTORY_MAX_NODES];                                         //bus inventory
+uint8_t nodecount = 0;
+
+void setup() {
+  Serial.begin(115200);                                                         //initialize serial
+  MFM.begin();                                                                  //initialize MFM communication
+
+#if defined ( MFM_USE_EEPROM )
+  nodecount = MFM.loadInventory(nodes, MFM_INVENTORY_MAX_NODES);                //try inventory from previous boot
+#endif
+  if (nodecount == 0) {                                                         //nothing stored -> scan bus 1..247
+    Serial.println("Discovering...");
+    nodecount = MFM.discover(nodes, MFM_INVENTORY_MAX_NODES);
+#if defined ( MFM_USE_EEPROM )
+    MFM.saveInventory(nodes, nodecount);
+#endif
+  }
+
+  for (uint8_t i = 0; i < nodecount; i++) {
+    Serial.print("Node: ");
+    Serial.print(nodes[i].node);
+    Serial.print("  model bits: 0x");
+    Serial.print(nodes[i].model, HEX);
+    Serial.print("  latency: ");
+    Serial.print(nodes[i].latency);
+    Serial.println("ms");
+  }
+}
+
+void loop() {
+  for (uint8_t i = 0; i < nodecount; i++) {
+    Serial.print("Node ");
+    Serial.print(nodes[i].node);
+    Serial.print(" Voltage: ");
+    if (nodes[i].model & ~MFM_MODEL_72D)                                        //MFM72D has no MFM_VOLTAGE_V1N
+      Serial.print(MFM.readVal(MFM_VOLTAGE_V1N, nodes[i].node), 2);
+    Serial.println("V");
+  }
+
+  delay(1000);                                                                  //wait a while before next loop
+}
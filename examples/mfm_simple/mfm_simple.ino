@@ -52,6 +52,8 @@ void loop() {
   sprintf(bufout, "%c[1;0H", 27);
   Serial.print(bufout);
 
+  MFM.beginSession();                                                           //keep software serial listening for all readings below
+
   Serial.print("Voltage:   ");
   Serial.print(MFM.readVal(MFM_VOLTAGE_V1N), 2);                            //display voltage
   Serial.println("V");
@@ -68,5 +70,7 @@ void loop() {
   Serial.print(MFM.readVal(MFM_FREQUENCY), 2);                                  //display frequency
   Serial.println("Hz");
 
+  MFM.endSession();
+
   delay(1000);                                                                  //wait a while before next loop
 }
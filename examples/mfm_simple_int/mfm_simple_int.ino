@@ -0,0 +1,72 @@
+//integer only version of mfm_simple, for small AVR boards
+//
+//REMEMBER! uncomment #define MFM_NO_FLOAT in MFM_Config_User.h file
+//to compile out the float readVal path
+
+#include <MFM.h>                                                                //import MFM library
+
+#if defined ( USE_HARDWARESERIAL )                                              //for HWSERIAL
+MFM MFM(Serial1, MFM_UART_BAUD, NOT_A_PIN);                                     //config MFM on Serial1 (if available!)
+#else                                                                           //for SWSERIAL
+#include <SoftwareSerial.h>                                                     //import SoftwareSerial library
+SoftwareSerial swSerMFM(MFM_RX_PIN, MFM_TX_PIN);                                //config SoftwareSerial
+MFM MFM(swSerMFM, MFM_UART_BAUD, NOT_A_PIN);                                    //config MFM
+#endif
+
+void printFixed(int32_t val, uint8_t decimals) {                                //print val / 10^decimals without float
+  if (val == MFM_INT_NAN) {
+    Serial.print(F("nan"));
+    return;
+  }
+  if (val < 0) {
+    Serial.print('-');
+    val = -val;
+  }
+  uint32_t div = 1;
+  for (uint8_t i = 0; i < decimals; i++)
+    div *= 10;
+  Serial.print((uint32_t)val / div);
+  if (decimals) {
+    Serial.print('.');
+    uint32_t frac = (uint32_t)val % div;
+    for (div /= 10; div > 1 && frac < div; div /= 10)                           //leading zeros of fraction
+      Serial.print('0');
+    Serial.print(frac);
+  }
+}
+
+void setup() {
+  Serial.begin(115200);                                                         //initialize serial
+  MFM.begin();                                                                  //initialize MFM communication
+}
+
+void loop() {
+  int32_t isum = 0;
+
+  Serial.print(F("Voltage:   "));
+  printFixed(MFM.readValInt(MFM_VOLTAGE_V1N), 3);                               //mV
+  Serial.println(F("V"));
+
+  for (uint8_t i = 0; i < 3; i++) {                                             //MFM_CURRENT_I1..I3 in mA
+    int32_t ma = MFM.readValInt(MFM_CURRENT_I1 + 2 * i);
+    if (ma != MFM_INT_NAN)
+      isum += ma;
+  }
+  Serial.print(F("Current:   "));
+  printFixed(isum, 3);                                                          //sum of phases
+  Serial.println(F("A"));
+
+  Serial.print(F("Power:     "));
+  printFixed(MFM.readValInt(MFM_TOTAL_KW), 0);                                  //kW -> W
+  Serial.println(F("W"));
+
+  Serial.print(F("Energy:    "));
+  printFixed(MFM.readValInt(MFM_KWH), 0);                                       //kWh -> Wh
+  Serial.println(F("Wh"));
+
+  Serial.print(F("Frequency: "));
+  printFixed(MFM.readValInt(MFM_FREQUENCY, MFM_B_01, 2), 2);                    //centi Hz
+  Serial.println(F("Hz"));
+
+  delay(1000);                                                                  //wait a while before next loop
+}
@@ -0,0 +1,72 @@
+//reading meters behind several Ethernet/WiFi to RS485 gateways (Modbus RTU over TCP)
+//one request in flight per gateway, all gateways polled at the same time
+
+#if defined ( ESP8266 )
+#include <ESP8266WiFi.h>
+#else
+#include <WiFi.h>
+#endif
+
+#include <MFMTcp.h>                                                             //import MFM tcp transport
+
+#define READMFMEVERY  2000                                                      //read all meters every 2000ms
+#define NBGW          2                                                         //number of gateways
+
+const char* wifi_ssid = "YOUR_SSID";
+const char* wifi_password = "YOUR_PASSWORD";
+
+WiFiClient gwclient[NBGW];                                                      //one connection per gateway
+IPAddress gwip[NBGW] = {
+  IPAddress(192, 168, 0, 201),
+  IPAddress(192, 168, 0, 202)
+};
+
+void result(uint8_t gateway, uint8_t node, uint16_t reg, uint16_t err, const uint32_t *raw, uint8_t count) {
+  Serial.print("gw ");
+  Serial.print(gateway);
+  Serial.print(" node ");
+  Serial.print(node);
+  Serial.print(" reg 0x");
+  Serial.print(reg, HEX);
+  if (err != MFM_ERR_NO_ERROR) {
+    Serial.print(" error ");
+    Serial.println(err);
+    return;
+  }
+  for (uint8_t i = 0; i < count; i++) {
+    float val;
+    memcpy(&val, &raw[i], sizeof(val));                                         //raw ieee754 value, or MFM::floatToInt(raw[i]) for scaled int
+    Serial.print(' ');
+    Serial.print(val, 2);
+  }
+  Serial.println();
+}
+
+MFMTcp MFMTcp(result);
+
+unsigned long readtime;
+
+void setup() {
+  Serial.begin(115200);                                                         //initialize serial
+
+  WiFi.mode(WIFI_STA);
+  WiFi.begin(wifi_ssid, wifi_password);
+  while (WiFi.status() != WL_CONNECTED)
+    delay(500);
+
+  for (uint8_t i = 0; i < NBGW; i++)
+    MFMTcp.addGateway(gwclient[i], gwip[i], MFM_TCP_PORT);
+}
+
+void loop() {
+  if (MFMTcp.idle() && millis() - readtime >= READMFMEVERY) {
+    for (uint8_t i = 0; i < NBGW; i++) {
+      MFMTcp.request(i, MFM_VOLTAGE_V1N, 0x01, 3);                              //MFM_VOLTAGE_V1N..V3N of node 1
+      MFMTcp.request(i, MFM_TOTAL_KW, 0x01);
+      MFMTcp.request(i, MFM_TOTAL_KW, 0x02);
+    }
+    readtime = millis();
+  }
+
+  MFMTcp.poll();                                                                //send/receive on all gateways
+}
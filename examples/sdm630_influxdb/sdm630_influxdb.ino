@@ -17,6 +17,9 @@ TX SSer/HSer swap D8|15                            |GND
 //REMEMBER! uncomment #define USE_HARDWARESERIAL 
 //in MFM_Config_User.h file if you want to use hardware uart
 
+//REMEMBER! uncomment #define MFM_USE_LITTLEFS
+//in MFM_Config_User.h file, snapshot log is stored with LittleFS (esp8266 core 2.6 or newer)
+
 #include <MFM.h>                                                                //import MFM library
 #include <ESP8266WiFi.h>
 #include <WiFiClient.h>
@@ -24,6 +27,8 @@ TX SSer/HSer swap D8|15                            |GND
 #include <WiFiUdp.h>
 #include <ArduinoOTA.h>
 #include <InfluxDbClient.h>           //https://github.com/tobiasschuerg/InfluxDB-Client-for-Arduino
+#include <LittleFS.h>
+#include <MFMLog.h>                                                             //keeps readings on flash while WiFi or InfluxDB is down
 
 
 
@@ -94,6 +99,7 @@ MFM MFM(swSerMFM, 9600, dere_pin);                                             /
 #endif //#if defined ( USE_HARDWARESERIAL )
 
 #define READMFMEVERY  1000                                                      //read MFM every 2000ms
+#define UPLOADMAXPERLOOP  2                                                     //max logged snapshots uploaded per loop pass, keeps polling on schedule
 #define NBREG   23    // SET TO the number of parameters in sdm_struct sdmarr[NBREG] and maximum 40 
 
 
@@ -134,6 +140,14 @@ time_t ntpLastUpdate;
 int ntpSyncTime = 3600;
 bool read_done = false;
 
+MFMLogLittleFS logstorage("/sdm630");
+MFMLog mfmlog(logstorage);
+
+typedef struct {                                                                //one snapshot record in MFMLog
+  uint32_t time;
+  float val[NBREG];
+} sdm_record;
+
 
 void setup() {
   //Serial.begin(115200);                                                         //initialize serial
@@ -175,6 +189,11 @@ void setup() {
   //Enable messages batching and retry buffer
   client.setWriteOptions(WRITE_PRECISION, MAX_BATCH_SIZE, WRITE_BUFFER_SIZE);
 
+  LittleFS.begin();
+  if (!mfmlog.begin()) {                                                        //continue with backlog from previous run
+    //Serial.println("Snapshot log unusable, check LittleFS");
+  }
+
 
   
 }
@@ -192,54 +211,18 @@ void loop() {
   }
 
   if(read_done){
-//put data to influx in buffer
-    time_t tnow = time(nullptr);
-    for (int i = 0; i < NBREG; i++) {
-      Point powerMeter("MFM630");
-      //powerMeter.addTag("device", "Main");
-      powerMeter.addTag("Type", sdmarr[i].regtext );
-      //powerMeter.addTag("channel", String(WiFi.channel(i)));
-      //powerMeter.addTag("open", String(WiFi.encryptionType(i) == WIFI_AUTH_OPEN));
-      powerMeter.addField("value", sdmarr[i].regvalarr);
-      powerMeter.setTime(tnow);  //set the time
-
-      // Print what are we exactly writing
-      //Serial.print("Writing: ");
-      //Serial.println(powerMeter.toLineProtocol());
-
-      // Write point into buffer - low priority measures
-      client.writePoint(powerMeter);
- 
-    }
-
-
-
-
-
-  // End of the iteration - force write of all the values into InfluxDB as single transaction
-  //Serial.println("Flushing data into InfluxDB");
-  if (!client.flushBuffer()) {
-    //Serial.print("InfluxDB flush failed: ");
-    //Serial.println(client.getLastErrorMessage());
-    //Serial.print("Full buffer: ");
-    //Serial.println(client.isBufferFull() ? "Yes" : "No");
-  }
-  
-
-  
-
-  
-    for(int i = 0; i < NBREG; i++) {
-      //Serial.print(sdmarr[i].regtext);
-      //Serial.print(" = ");
-      //Serial.println(sdmarr[i].regvalarr);
-    
-    }
+//store snapshot in log, uploaded below as soon as server is reachable
+    sdm_record rec;
+    rec.time = time(nullptr);
+    for (int i = 0; i < NBREG; i++)
+      rec.val[i] = sdmarr[i].regvalarr;
+    mfmlog.append((const uint8_t *)&rec, sizeof(rec));
     read_done = false;
-    
-    
   }
 
+  if (WiFi.status() == WL_CONNECTED)
+    uploadLog();
+
   ArduinoOTA.handle();
   yield();
   /*Serial.println("Wait 10s");
@@ -275,9 +258,43 @@ void timeSync() {
 
 
 
+void uploadLog() {
+  sdm_record rec;
+
+  //upload part of backlog, one snapshot (NBREG points) per flush fits in WRITE_BUFFER_SIZE
+  for (uint8_t n = 0; n < UPLOADMAXPERLOOP; n++) {
+    int16_t len = mfmlog.read((uint8_t *)&rec, sizeof(rec));
+    if (len < 0)                                                                //backlog empty
+      return;
+    if (len != (int16_t)sizeof(rec)) {                                          //record of other firmware (NBREG changed), skip it
+      mfmlog.commit();
+      continue;
+    }
+
+    for (int i = 0; i < NBREG; i++) {
+      Point powerMeter("MFM630");
+      powerMeter.addTag("Type", sdmarr[i].regtext);
+      powerMeter.addField("value", rec.val[i]);
+      powerMeter.setTime(rec.time);
+      client.writePoint(powerMeter);
+    }
+
+    if (!client.flushBuffer()) {
+      //Serial.print("InfluxDB flush failed: ");
+      //Serial.println(client.getLastErrorMessage());
+      client.resetBuffer();                                                     //snapshot stays in log
+      mfmlog.rewind();
+      return;
+    }
+    mfmlog.commit();
+    yield();
+  }
+}
+
 void sdmRead() {
   float tmpval = NAN;
 
+  MFM.beginSession();                                                           //keep software serial listening for whole poll plan
   for (uint8_t i = 0; i < NBREG; i++) {
     tmpval = MFM.readVal(sdmarr[i].regarr);
 
@@ -288,5 +305,6 @@ void sdmRead() {
 
     yield();
   }
+  MFM.endSession();
   read_done = true;
 }
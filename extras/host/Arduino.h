@@ -0,0 +1,49 @@
+/* Minimal Arduino api for building and testing the library on a pc (see Makefile).
+*  Time is simulated: millis() advances only in delay(), yield() (1 ms) and hostAdvance(),
+*  so tests run instantly and give the same result on every run.
+*/
+//------------------------------------------------------------------------------
+#ifndef Arduino_h
+#define Arduino_h
+//------------------------------------------------------------------------------
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+//------------------------------------------------------------------------------
+#define NOT_A_PIN                                     -1
+#define OUTPUT                                        1
+#define LOW                                           0
+#define HIGH                                          1
+#define SERIAL_8N1                                    0x06
+
+#define lowByte(w)                                    ((uint8_t)((w) & 0xFF))
+#define highByte(w)                                   ((uint8_t)((w) >> 8))
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void yield();
+void pinMode(int pin, int mode);
+void digitalWrite(int pin, int val);
+
+void hostAdvance(unsigned long ms);                                             //  move simulated time forward (test loops)
+
+class Stream {
+public:
+    virtual ~Stream() {}
+    virtual int available() { return (0); }
+    virtual int read() { return (-1); }
+    virtual int peek() { return (-1); }
+    virtual size_t write(uint8_t) { return (1); }
+    virtual size_t write(const uint8_t *, size_t len) { return (len); }
+    virtual void flush() {}
+    void setTimeout(unsigned long timeout) { _timeout = timeout; }
+
+protected:
+    unsigned long _timeout = 1000;
+};
+
+#endif // Arduino_h
@@ -0,0 +1,18 @@
+/* Host Client interface (subset of Arduino Client used by MFMTcp).
+*/
+//------------------------------------------------------------------------------
+#ifndef Client_h
+#define Client_h
+//------------------------------------------------------------------------------
+#include <Arduino.h>
+#include <IPAddress.h>
+//------------------------------------------------------------------------------
+class Client : public Stream {
+public:
+    virtual int connect(IPAddress ip, uint16_t port) = 0;
+    virtual uint8_t connected() = 0;
+    virtual void stop() = 0;
+    using Stream::write;
+};
+
+#endif // Client_h
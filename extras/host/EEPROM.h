@@ -0,0 +1,21 @@
+/* Host EEPROM (avr style, 1 KB in ram).
+*/
+//------------------------------------------------------------------------------
+#ifndef EEPROM_h
+#define EEPROM_h
+//------------------------------------------------------------------------------
+#include <Arduino.h>
+//------------------------------------------------------------------------------
+class EEPROMClass {
+public:
+    uint8_t read(int addr) { return (mem[addr]); }
+    void write(int addr, uint8_t val) { mem[addr] = val; }
+    uint16_t length() { return (sizeof(mem)); }
+
+private:
+    uint8_t mem[1024];
+};
+
+static EEPROMClass EEPROM;
+
+#endif // EEPROM_h
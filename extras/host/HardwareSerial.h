@@ -0,0 +1,23 @@
+/* Host HardwareSerial connected to a simulated bus (MFMSim.h).
+*/
+//------------------------------------------------------------------------------
+#ifndef HardwareSerial_h
+#define HardwareSerial_h
+//------------------------------------------------------------------------------
+#include "MFMSim.h"
+//------------------------------------------------------------------------------
+class HardwareSerial : public Stream {
+public:
+    HardwareSerial(MFMSimBus &bus) : _bus(bus) {}
+
+    void begin(long, int = SERIAL_8N1) {}
+    int available() { return (_bus.available()); }
+    int read() { return (_bus.read()); }
+    size_t write(const uint8_t *buf, size_t len) { _bus.request(buf, len); return (len); }
+    using Stream::write;
+
+private:
+    MFMSimBus &_bus;
+};
+
+#endif // HardwareSerial_h
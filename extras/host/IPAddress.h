@@ -0,0 +1,17 @@
+/* Host IPAddress (only stored, never resolved).
+*/
+//------------------------------------------------------------------------------
+#ifndef IPAddress_h
+#define IPAddress_h
+//------------------------------------------------------------------------------
+#include <Arduino.h>
+//------------------------------------------------------------------------------
+class IPAddress {
+public:
+    IPAddress() {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) { addr[0] = a; addr[1] = b; addr[2] = c; addr[3] = d; }
+
+    uint8_t addr[4] = {0, 0, 0, 0};
+};
+
+#endif // IPAddress_h
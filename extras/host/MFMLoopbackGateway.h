@@ -0,0 +1,43 @@
+/* Loopback stand-in for an Ethernet/WiFi to RS485 gateway (Modbus RTU over TCP),
+*  backed by simulated meters. Implements Client, so it can be passed to
+*  MFMTcp::addGateway() in host tests instead of WiFiClient/EthernetClient.
+*/
+//------------------------------------------------------------------------------
+#ifndef MFMLoopbackGateway_h
+#define MFMLoopbackGateway_h
+//------------------------------------------------------------------------------
+#include <Client.h>
+#include "MFMSim.h"
+//------------------------------------------------------------------------------
+class MFMLoopbackGateway : public Client {
+public:
+    int connect(IPAddress, uint16_t) {
+        connects++;
+        if (!reachable) {
+            delay(_timeout);                                                        //like esp WiFiClient, blocks until setTimeout()
+            return (0);
+        }
+        up = true;
+        return (1);
+    }
+    uint8_t connected() { return (up); }
+    void stop() { up = false; bus.clear(); }                                    //  gateway drops reply of request in flight
+    int available() { return (up ? bus.available() : 0); }
+    int read() { return (up ? bus.read() : -1); }
+    size_t write(const uint8_t *buf, size_t len) {
+        if (!up)
+            return (0);
+        bus.request(buf, len);
+        return (len);
+    }
+    using Client::write;
+
+    MFMSimBus bus;                                                              //  RS485 bus behind the gateway, latency includes network
+    bool reachable = true;
+    uint32_t connects = 0;
+
+private:
+    bool up = false;
+};
+
+#endif // MFMLoopbackGateway_h
@@ -0,0 +1,121 @@
+/* Simulated MFM meters on a RS485 bus, for host tests.
+*  Also provides the simulated clock of Arduino.h.
+*/
+//------------------------------------------------------------------------------
+#include "MFMSim.h"
+#include <vector>
+//------------------------------------------------------------------------------
+static unsigned long simtime = 0;
+
+unsigned long millis() {
+    return (simtime);
+}
+
+unsigned long micros() {
+    return (simtime * 1000);
+}
+
+void delay(unsigned long ms) {
+    simtime += ms;
+}
+
+void yield() {                                                                    //busy wait loops advance time
+    simtime++;
+}
+
+void pinMode(int, int) {
+}
+
+void digitalWrite(int, int) {
+}
+
+void hostAdvance(unsigned long ms) {
+    simtime += ms;
+}
+
+uint16_t MFMSimCRC(const uint8_t *buf, size_t len) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= buf[i];
+        for (uint8_t j = 8; j; j--)
+            crc = (crc & 0x0001) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+    }
+    return (crc);
+}
+//------------------------------------------------------------------------------
+void MFMSimBus::addMeter(uint8_t node, MFMSimValue value) {
+    Meter m;
+    m.node = node;
+    m.value = value;
+    meters.push_back(m);
+}
+
+void MFMSimBus::request(const uint8_t *frame, size_t len) {
+    std::vector<uint8_t> reply;
+    const Meter *meter = NULL;
+    uint16_t lat = latencyOnce ? latencyOnce : latency;
+
+    requests++;
+    latencyOnce = 0;
+    if (mute || len != 8 || MFMSimCRC(frame, 6) != ((frame[7] << 8) | frame[6]))
+        return;
+
+    for (size_t i = 0; i < meters.size(); i++) {
+        if (meters[i].node == frame[0])
+            meter = &meters[i];
+    }
+    if (meter == NULL)                                                            //nobody at this address
+        return;
+
+    uint16_t reg = (frame[2] << 8) | frame[3];
+    uint16_t words = (frame[4] << 8) | frame[5];
+    reply.push_back(frame[0]);
+    reply.push_back(frame[1]);
+    reply.push_back(words * 2);
+    for (uint16_t i = 0; i < words / 2; i++) {
+        float val;
+        uint32_t raw;
+        if (!meter->value(frame[0], reg + i * 2, val)) {                            //illegal data address exception
+            if (!exceptions)
+                return;
+            reply.resize(2);
+            reply[1] |= 0x80;
+            reply.push_back(0x02);
+            break;
+        }
+        memcpy(&raw, &val, sizeof(raw));
+        reply.push_back(raw >> 24);
+        reply.push_back(raw >> 16);
+        reply.push_back(raw >> 8);
+        reply.push_back(raw);
+    }
+    uint16_t crc = MFMSimCRC(reply.data(), reply.size());
+    reply.push_back(crc & 0xFF);
+    reply.push_back(crc >> 8);
+    if (corruptNext) {
+        corruptNext--;
+        reply.back() ^= 0x55;
+    }
+
+    for (size_t i = 0; i < reply.size(); i++)                                     //about one byte per ms at 9600 baud
+        pending.push_back(std::make_pair(millis() + lat + i, reply[i]));
+}
+
+int MFMSimBus::available() {
+    int n = 0;
+    for (size_t i = 0; i < pending.size() && pending[i].first <= millis(); i++)
+        n++;
+    return (n);
+}
+
+int MFMSimBus::read() {
+    if (available() == 0)
+        return (-1);
+    int c = pending.front().second;
+    pending.pop_front();
+    return (c);
+}
+
+void MFMSimBus::clear() {
+    pending.clear();
+}
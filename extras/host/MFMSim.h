@@ -0,0 +1,44 @@
+/* Simulated MFM meters on a RS485 bus, for host tests.
+*  Replies to function 0x04 requests like a meter: values in big endian ieee754,
+*  exception reply for unsupported registers, one byte per ms after a latency.
+*/
+//------------------------------------------------------------------------------
+#ifndef MFMSim_h
+#define MFMSim_h
+//------------------------------------------------------------------------------
+#include <Arduino.h>
+#include <deque>
+#include <functional>
+#include <utility>
+//------------------------------------------------------------------------------
+typedef std::function<bool(uint8_t node, uint16_t reg, float &val)> MFMSimValue;  //  false = register not supported
+
+class MFMSimBus {
+public:
+    void addMeter(uint8_t node, MFMSimValue value);
+
+    void request(const uint8_t *frame, size_t len);                             //  master frame written to bus
+    int available();
+    int read();
+    void clear();                                                               //  drop reply bytes not yet read (connection closed)
+
+    uint16_t latency = 5;                                                       //  ms from request to first reply byte
+    uint16_t latencyOnce = 0;                                                   //  latency of next reply only, 0 = unused
+    bool mute = false;                                                          //  meters do not answer
+    bool exceptions = true;                                                     //  exception reply for unsupported registers, false = silence
+    uint8_t corruptNext = 0;                                                    //  number of next replies with damaged crc (bus noise)
+    uint32_t requests = 0;
+
+private:
+    struct Meter {
+        uint8_t node;
+        MFMSimValue value;
+    };
+
+    std::deque<Meter> meters;
+    std::deque<std::pair<unsigned long, uint8_t> > pending;                     //  reply bytes with time they appear on the bus
+};
+
+uint16_t MFMSimCRC(const uint8_t *buf, size_t len);
+
+#endif // MFMSim_h
@@ -0,0 +1,24 @@
+/* Minimal check macro for host tests.
+*/
+//------------------------------------------------------------------------------
+#ifndef MFMTest_h
+#define MFMTest_h
+//------------------------------------------------------------------------------
+#include <stdio.h>
+//------------------------------------------------------------------------------
+static int testfailures = 0;
+
+#define TEST(cond)                                                              \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            printf("%s:%d: FAILED: %s\n", __FILE__, __LINE__, #cond);           \
+            testfailures++;                                                     \
+        }                                                                       \
+    } while (0)
+
+static int testResult(const char *name) {
+    printf("%s: %s\n", name, testfailures ? "FAILED" : "OK");
+    return (testfailures ? 1 : 0);
+}
+
+#endif // MFMTest_h
@@ -0,0 +1,72 @@
+/* Host timing of value decoding: readVal (raw -> float, and float scaled to int
+*  in the sketch) against readValInt (MFM::floatToInt, integer only).
+*  Only the decoding is timed, the bus transaction is the same for both.
+*  On a pc float is done in hardware, so this shows the relative cost at best;
+*  on avr the float path uses the soft float library (see extras/size.sh).
+*/
+//------------------------------------------------------------------------------
+#include <MFM.h>
+#include <time.h>
+//------------------------------------------------------------------------------
+#define BENCH_VALUES                                  1024
+#define BENCH_ROUNDS                                  10000
+
+static uint32_t raws[BENCH_VALUES];
+static volatile int32_t sinkInt;
+static volatile float sinkFloat;
+
+static double nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec * 1e9 + ts.tv_nsec);
+}
+
+static double benchFloat() {                                                    //what readVal does after readRaw
+    double start = nowNs();
+    for (uint32_t r = 0; r < BENCH_ROUNDS; r++) {
+        for (uint16_t i = 0; i < BENCH_VALUES; i++) {
+            float val;
+            memcpy(&val, &raws[i], sizeof(val));
+            sinkFloat = val;
+        }
+    }
+    return ((nowNs() - start) / ((double)BENCH_ROUNDS * BENCH_VALUES));
+}
+
+static double benchFloatScaled() {                                              //readVal and scaling to mV etc. in the sketch
+    double start = nowNs();
+    for (uint32_t r = 0; r < BENCH_ROUNDS; r++) {
+        for (uint16_t i = 0; i < BENCH_VALUES; i++) {
+            float val;
+            memcpy(&val, &raws[i], sizeof(val));
+            sinkInt = (int32_t)lroundf(val * 1000.0f);
+        }
+    }
+    return ((nowNs() - start) / ((double)BENCH_ROUNDS * BENCH_VALUES));
+}
+
+static double benchInt() {                                                      //what readValInt does after readRaw
+    double start = nowNs();
+    for (uint32_t r = 0; r < BENCH_ROUNDS; r++) {
+        for (uint16_t i = 0; i < BENCH_VALUES; i++)
+            sinkInt = MFM::floatToInt(raws[i], 3);
+    }
+    return ((nowNs() - start) / ((double)BENCH_ROUNDS * BENCH_VALUES));
+}
+
+int main() {
+    uint32_t seed = 1;
+
+    for (uint16_t i = 0; i < BENCH_VALUES; i++) {                                 //meter like values: 0.001 .. 100000, some negative
+        seed = seed * 1103515245UL + 12345;
+        float val = (float)((seed >> 8) % 100000000UL) / 1000.0f;
+        if (seed & 0x80000000UL)
+            val = -val;
+        memcpy(&raws[i], &val, sizeof(val));
+    }
+
+    printf("readVal decode (float):          %6.2f ns/value\n", benchFloat());
+    printf("readVal decode + scale to int:   %6.2f ns/value\n", benchFloatScaled());
+    printf("readValInt decode (floatToInt):  %6.2f ns/value\n", benchInt());
+    return (0);
+}
@@ -0,0 +1,69 @@
+/* Host test of MFM discovery, model fingerprint and inventory on a simulated bus.
+*/
+//------------------------------------------------------------------------------
+#include <MFM.h>
+#include "MFMTest.h"
+//------------------------------------------------------------------------------
+static bool meter630(uint8_t, uint16_t reg, float &val) {                        //three phase, no per phase thd of current
+    val = 230.0;
+    return (reg != MFM_THD_CURRENT_I1);
+}
+
+static bool meter230(uint8_t, uint16_t reg, float &val) {                        //single phase
+    val = 230.0;
+    return (reg != MFM_VOLTAGE_V2N && reg != MFM_KW_MIN_ACTIVE_POWER);
+}
+
+int main() {
+    MFMSimBus bus;
+    HardwareSerial serial(bus);
+    MFM mfm(serial);
+    MFMNode nodes[8];
+    uint8_t found;
+
+    mfm.begin();
+    bus.addMeter(5, meter630);
+    bus.addMeter(9, meter230);
+
+    //exception replies for unsupported registers
+    found = mfm.discover(nodes, 8, 1, 12);
+    TEST(found == 2);
+    TEST(nodes[0].node == 5 && nodes[0].model == MFM_MODEL_630);
+    TEST(nodes[1].node == 9 && nodes[1].model == MFM_MODEL_230);
+
+    //meters silent for unsupported registers
+    bus.exceptions = false;
+    TEST(mfm.fingerprint(5, nodes[0].latency) == MFM_MODEL_630);
+    TEST(mfm.fingerprint(9, nodes[1].latency) == MFM_MODEL_230);
+    bus.exceptions = true;
+
+    //bus noise or one slow reply must not remove the right model
+    bus.corruptNext = 1;
+    TEST(mfm.fingerprint(5, nodes[0].latency) == MFM_MODEL_630);
+    bus.corruptNext = 2;
+    TEST(mfm.fingerprint(9, nodes[1].latency) == MFM_MODEL_230);
+    bus.latencyOnce = 150;
+    TEST(mfm.fingerprint(5, nodes[0].latency) == MFM_MODEL_630);
+
+    //persistent garbage: ambiguous, but still contains the right model
+    bus.corruptNext = 255;
+    TEST(mfm.fingerprint(5, nodes[0].latency) & MFM_MODEL_630);
+    bus.corruptNext = 0;
+
+    //exception is reported as such
+    TEST(isnan(mfm.readVal(MFM_THD_CURRENT_I1, 5)));
+    TEST(mfm.getErrCode(true) == MFM_ERR_EXCEPTION);
+
+    //slow meters are found
+    bus.latency = 120;
+    found = mfm.discover(nodes, 8, 1, 12);
+    TEST(found == 2 && nodes[0].latency >= 120);
+
+    //inventory round trip
+    TEST(mfm.saveInventory(nodes, found));
+    MFMNode loaded[8];
+    TEST(mfm.loadInventory(loaded, 8) == found);
+    TEST(loaded[1].node == 9 && loaded[1].model == MFM_MODEL_230);
+
+    return (testResult("test_discovery"));
+}
@@ -0,0 +1,114 @@
+/* Host test of MFMLog with plain file storage: recovery after reboot,
+*  long directory prefix, corrupted meta and segments left by a reset.
+*/
+//------------------------------------------------------------------------------
+#include <MFMLog.h>
+#include <stdlib.h>
+#include "MFMTest.h"
+//------------------------------------------------------------------------------
+#define RECORD_SIZE                                   40
+
+static void appendRecords(MFMLog &log, uint32_t from, uint32_t count) {
+    uint8_t rec[RECORD_SIZE];
+    memset(rec, 0, sizeof(rec));
+    for (uint32_t i = from; i < from + count; i++) {
+        memcpy(rec, &i, sizeof(i));
+        TEST(log.append(rec, sizeof(rec)));
+    }
+    TEST(log.flush());
+}
+
+static uint32_t readAll(MFMLog &log, uint32_t &first, uint32_t &last) {         //return number of records, first and last record number
+    uint8_t rec[RECORD_SIZE];
+    uint32_t n = 0;
+    while (log.read(rec, sizeof(rec)) == RECORD_SIZE) {
+        memcpy(n ? &last : &first, rec, sizeof(uint32_t));
+        if (n == 0)
+            last = first;
+        n++;
+    }
+    return (n);
+}
+
+static void makeDir(const char *dir) {
+    char cmd[512];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s && mkdir -p %s", dir, dir);
+    TEST(system(cmd) == 0);
+}
+
+static void rebootAppend(const char *dir) {                                     //3 boots appending 100 records each, nothing uploaded
+    char prefix[256];
+    uint32_t first = 0, last = 0;
+
+    makeDir(dir);
+    snprintf(prefix, sizeof(prefix), "%s/log", dir);
+    MFMLogFile fs(prefix);
+    for (uint32_t boot = 0; boot < 3; boot++) {
+        MFMLog log(fs);
+        TEST(log.begin());
+        appendRecords(log, boot * 100, 100);
+    }
+    MFMLog log(fs);
+    TEST(log.begin());
+    TEST(readAll(log, first, last) == 300);
+    TEST(first == 0 && last == 299);
+}
+
+int main() {
+    uint32_t first = 0, last = 0;
+
+    //write position recovered from segment files, short and long directory
+    rebootAppend("/tmp/mfmlogtest");
+    rebootAppend("/tmp/mfmlogtest/a_rather_long_directory_name_to_exceed_sixty_four_chars_of_path");
+
+    //prefix too long for segment paths or directory missing: begin fails, nothing is appended
+    {
+        char prefix[300];
+        memset(prefix, 'x', sizeof(prefix));
+        prefix[0] = '/';
+        prefix[sizeof(prefix) - 1] = 0;
+        MFMLogFile fs(prefix);
+        MFMLog log(fs);
+        TEST(!log.begin());
+        TEST(!log.append((const uint8_t *)"x", 1));
+        MFMLogFile missing("/tmp/mfmlogtest/missing/log");
+        MFMLog log2(missing);
+        TEST(!log2.begin());
+    }
+
+    //consume, reboot, corrupt meta, leftover segment
+    makeDir("/tmp/mfmlogtest");
+    MFMLogFile fs("/tmp/mfmlogtest/log");
+    {
+        MFMLog log(fs);
+        uint8_t rec[RECORD_SIZE];
+        TEST(log.begin());
+        appendRecords(log, 0, 400);
+        for (uint32_t i = 0; i < 200; i++)
+            log.read(rec, sizeof(rec));
+        log.commit();
+        TEST(log.sync());
+        TEST(fs.size(0) < 0 && fs.size(1) < 0);                                   //consumed segments removed
+    }
+    {
+        MFMLog log(fs);
+        TEST(log.begin());
+        TEST(readAll(log, first, last) == 208);                                   //from start of cursor segment
+        TEST(first == 192 && last == 399);
+    }
+    TEST(system("cp /tmp/mfmlogtest/log2.log /tmp/mfmlogtest/log0.log") == 0);  //reset between meta write and remove
+    {
+        MFMLog log(fs);
+        TEST(log.begin());
+        TEST(fs.size(0) < 0);
+    }
+    TEST(system("printf garbage! > /tmp/mfmlogtest/log.meta") == 0);
+    {
+        MFMLog log(fs);
+        TEST(log.begin());
+        TEST(readAll(log, first, last) == 208);                                   //oldest segment, nothing lost
+        TEST(first == 192 && last == 399);
+    }
+
+    return (testResult("test_log"));
+}
@@ -0,0 +1,105 @@
+/* Host test of MFMTcp against loopback gateways with simulated meters.
+*/
+//------------------------------------------------------------------------------
+#include <MFMTcp.h>
+#include "MFMLoopbackGateway.h"
+#include "MFMTest.h"
+//------------------------------------------------------------------------------
+struct Result {
+    uint8_t gateway;
+    uint8_t node;
+    uint16_t reg;
+    uint16_t err;
+    float val;
+};
+
+static Result results[64];
+static uint8_t nresults = 0;
+
+static void result(uint8_t gateway, uint8_t node, uint16_t reg, uint16_t err, const uint32_t *raw, uint8_t count) {
+    Result &r = results[nresults++ % 64];
+    r.gateway = gateway;
+    r.node = node;
+    r.reg = reg;
+    r.err = err;
+    r.val = NAN;
+    if (err == MFM_ERR_NO_ERROR && count)
+        memcpy(&r.val, &raw[0], sizeof(float));
+}
+
+static bool meterValue(uint8_t node, uint16_t reg, float &val) {                 //value encodes node and register
+    if (reg > MFM_CURRENT_I3)
+        return (false);
+    val = node * 1000 + reg;
+    return (true);
+}
+
+static void run(MFMTcp &tcp) {
+    while (!tcp.idle()) {
+        tcp.poll();
+        hostAdvance(1);
+    }
+}
+
+int main() {
+    MFMLoopbackGateway gw[3];
+    MFMTcp tcp(result);
+
+    for (uint8_t i = 0; i < 3; i++) {
+        gw[i].bus.addMeter(1, meterValue);
+        gw[i].bus.addMeter(2, meterValue);
+        gw[i].bus.latency = 50;
+        TEST(tcp.addGateway(gw[i], IPAddress(127, 0, 0, 1), 502, 1000) == i);
+    }
+
+    //parallel block reads on all gateways
+    nresults = 0;
+    unsigned long start = millis();
+    for (uint8_t i = 0; i < 3; i++) {
+        tcp.request(i, MFM_VOLTAGE_V1N, 1, 3);
+        tcp.request(i, MFM_CURRENT_I1, 2);
+    }
+    run(tcp);
+    TEST(nresults == 6);
+    for (uint8_t i = 0; i < 6; i++) {
+        TEST(results[i].err == MFM_ERR_NO_ERROR);
+        TEST(results[i].val == results[i].node * 1000 + results[i].reg);
+    }
+    TEST(millis() - start < 2 * 150);                                             //gateways served in parallel
+
+    //exception reply for unsupported register
+    nresults = 0;
+    start = millis();
+    tcp.request(0, MFM_TOTAL_KW, 1);
+    run(tcp);
+    TEST(nresults == 1 && results[0].err == MFM_ERR_EXCEPTION);
+    TEST(millis() - start < 1000);                                                //no need to wait for turnaround
+
+    //reply later than turnaround must not be taken as reply to next request
+    nresults = 0;
+    gw[0].bus.latencyOnce = 1500;
+    for (uint8_t i = 0; i < 6; i++)
+        tcp.request(0, MFM_VOLTAGE_V1N + i * 2, 1);
+    run(tcp);
+    TEST(nresults == 6);
+    TEST(results[0].err == MFM_ERR_TIMEOUT);
+    for (uint8_t i = 1; i < 6; i++) {
+        TEST(results[i].err == MFM_ERR_NO_ERROR);
+        TEST(results[i].val == 1000 + MFM_VOLTAGE_V1N + i * 2);
+    }
+
+    //unreachable gateway blocks in connect(), others keep going
+    nresults = 0;
+    gw[2].reachable = false;
+    gw[2].stop();
+    tcp.request(2, MFM_VOLTAGE_V1N, 1);
+    for (uint8_t i = 0; i < 4; i++)
+        tcp.request(0, MFM_VOLTAGE_V1N, 1);
+    run(tcp);
+    TEST(nresults == 5);
+    for (uint8_t i = 0; i < nresults; i++)
+        TEST(results[i].err == (results[i].gateway == 2 ? MFM_ERR_TIMEOUT : MFM_ERR_NO_ERROR));
+    TEST(gw[2].connects == 2);                                                    //one failed attempt, no retry storm
+
+    return (testResult("test_tcp"));
+}
@@ -0,0 +1,20 @@
+#!/bin/sh
+# Flash and ram usage of mfm_simple (float) against mfm_simple_int (integer),
+# the latter with and without MFM_NO_FLOAT.
+# Needs arduino-cli with the avr core: arduino-cli core install arduino:avr
+# Run from the library root: sh extras/size.sh [fqbn], default arduino:avr:uno
+FQBN=${1:-arduino:avr:uno}
+LIB=$(cd "$(dirname "$0")/.." && pwd)
+
+measure() {
+    printf '%-40s' "$1"
+    arduino-cli compile --fqbn "$FQBN" --library "$LIB" \
+        --build-property "compiler.cpp.extra_flags=$3" "$LIB/examples/$2" 2>&1 |
+        sed -n 's/^Sketch uses \([0-9]*\) bytes.*/flash \1 /p; s/^Global variables use \([0-9]*\) bytes.*/ram \1/p' |
+        tr -d '\n'
+    echo
+}
+
+measure "mfm_simple" mfm_simple ""
+measure "mfm_simple_int" mfm_simple_int ""
+measure "mfm_simple_int, MFM_NO_FLOAT" mfm_simple_int "-DMFM_NO_FLOAT"